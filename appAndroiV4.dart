@@ -1,453 +1,706 @@
-import 'dart:io';
-import 'dart:typed_data';
-import 'package:flutter/material.dart';
-import 'package:flutter/services.dart';
-import 'package:flutter_joystick/flutter_joystick.dart';
-import 'package:flutter_mjpeg/flutter_mjpeg.dart';
-
-/// Dịch vụ UDP gửi dữ liệu dạng binary (6 bytes: 2 byte cho j1X, 2 byte cho j1Y, 2 byte cho speed)
-class UdpService {
-  RawDatagramSocket? _socket;
-  InternetAddress _targetAddress = InternetAddress('192.168.1.100');
-  int _port = 65000;
-
-  // Callback để gửi thông báo log lên giao diện
-  Function(String)? _logCallback;
-
-  UdpService({Function(String)? logCallback}) {
-    _logCallback = logCallback;
-  }
-
-  Future<void> init() async {
-    try {
-      _socket = await RawDatagramSocket.bind(InternetAddress.anyIPv4, 0);
-      _logCallback?.call('UDP socket initialized');
-    } catch (e) {
-      _logCallback?.call('Failed to initialize UDP socket: $e');
-    }
-  }
-
-  void updateTarget(String ip, int port) {
-    try {
-      _targetAddress = InternetAddress(ip);
-      _port = port;
-      _logCallback?.call('Updated UDP target: IP=$_targetAddress, Port=$_port');
-    } catch (e) {
-      _logCallback?.call('Invalid IP or Port: $e');
-    }
-  }
-
-  // Hàm gửi dữ liệu dạng byte
-  void sendData(Uint8List data) {
-    if (_socket != null) {
-      try {
-        _socket!.send(data, _targetAddress, _port);
-        _logCallback?.call('Sent UDP binary data: $data to $_targetAddress:$_port');
-      } catch (e) {
-        _logCallback?.call('Failed to send UDP data: $e');
-      }
-    } else {
-      _logCallback?.call('Socket is not initialized');
-    }
-  }
-
-  void close() {
-    _socket?.close();
-    _socket = null;
-    _logCallback?.call('UDP socket closed');
-  }
-}
-
-void main() {
-  WidgetsFlutterBinding.ensureInitialized();
-  SystemChrome.setPreferredOrientations([
-    DeviceOrientation.landscapeLeft,
-    DeviceOrientation.landscapeRight,
-  ]).then((_) {
-    runApp(const MyApp());
-  });
-}
-
-class MyApp extends StatelessWidget {
-  const MyApp({super.key});
-  @override
-  Widget build(BuildContext context) {
-    return MaterialApp(
-      title: 'UDP Controller',
-      debugShowCheckedModeBanner: false,
-      home: const SettingsPage(),
-    );
-  }
-}
-
-/// Trang cài đặt để nhập địa chỉ IP, cổng UDP và cài đặt Camera
-class SettingsPage extends StatefulWidget {
-  const SettingsPage({super.key});
-  @override
-  State<SettingsPage> createState() => _SettingsPageState();
-}
-
-class _SettingsPageState extends State<SettingsPage> {
-  late final UdpService _udpService;
-  final TextEditingController _ipController =
-  TextEditingController(text: '192.168.1.100');
-  final TextEditingController _portController =
-  TextEditingController(text: '65000');
-
-  // Controller cho camera
-  final TextEditingController _cameraIpController =
-  TextEditingController(text: '192.168.1.101');
-  final TextEditingController _cameraPortController =
-  TextEditingController(text: '2003');
-
-  @override
-  void initState() {
-    super.initState();
-    _udpService = UdpService(logCallback: (log) {
-      debugPrint(log);
-    });
-    _udpService.init();
-  }
-
-  @override
-  void dispose() {
-    _ipController.dispose();
-    _portController.dispose();
-    _cameraIpController.dispose();
-    _cameraPortController.dispose();
-    super.dispose();
-  }
-
-  void _saveUdpSettings() {
-    String ip = _ipController.text;
-    int port = int.tryParse(_portController.text) ?? 65000;
-    _udpService.updateTarget(ip, port);
-
-    // Lấy thông tin camera
-    String camIp = _cameraIpController.text;
-    int camPort = int.tryParse(_cameraPortController.text) ?? 80;
-    debugPrint('Camera settings: IP=$camIp, Port=$camPort');
-
-    Navigator.pushReplacement(
-      context,
-      MaterialPageRoute(
-        builder: (context) => ControlPage(
-          udpService: _udpService,
-          cameraIp: camIp,
-          cameraPort: camPort,
-        ),
-      ),
-    );
-  }
-
-  @override
-  Widget build(BuildContext context) {
-    // Sử dụng SingleChildScrollView để tránh bottom overflow khi bàn phím xuất hiện.
-    return Scaffold(
-      appBar: AppBar(title: const Text('Cài đặt')),
-      body: SingleChildScrollView(
-        padding: const EdgeInsets.all(20.0),
-        child: ConstrainedBox(
-          constraints: BoxConstraints(
-            minHeight: MediaQuery.of(context).size.height -
-                kToolbarHeight -
-                MediaQuery.of(context).padding.top,
-          ),
-          child: IntrinsicHeight(
-            child: Column(
-              mainAxisAlignment: MainAxisAlignment.center,
-              children: [
-                // Hàng nhập liệu cho UDP: Địa chỉ IP và Cổng UDP
-                Row(
-                  children: [
-                    Expanded(
-                      child: TextField(
-                        controller: _ipController,
-                        decoration:
-                        const InputDecoration(labelText: 'Địa chỉ IP'),
-                      ),
-                    ),
-                    const SizedBox(width: 10),
-                    Expanded(
-                      child: TextField(
-                        controller: _portController,
-                        decoration:
-                        const InputDecoration(labelText: 'Cổng UDP'),
-                        keyboardType: TextInputType.number,
-                      ),
-                    ),
-                  ],
-                ),
-                const SizedBox(height: 20),
-                // Hàng nhập liệu cho Camera: Địa chỉ Camera và Cổng Camera
-                Row(
-                  children: [
-                    Expanded(
-                      child: TextField(
-                        controller: _cameraIpController,
-                        decoration: const InputDecoration(
-                            labelText: 'Địa chỉ Camera'),
-                      ),
-                    ),
-                    const SizedBox(width: 10),
-                    Expanded(
-                      child: TextField(
-                        controller: _cameraPortController,
-                        decoration: const InputDecoration(
-                            labelText: 'Cổng Camera'),
-                        keyboardType: TextInputType.number,
-                      ),
-                    ),
-                  ],
-                ),
-                const SizedBox(height: 20),
-                ElevatedButton(
-                  onPressed: _saveUdpSettings,
-                  child: const Text('Lưu & Điều khiển'),
-                ),
-              ],
-            ),
-          ),
-        ),
-      ),
-    );
-  }
-}
-
-/// Trang điều khiển sử dụng Joystick để gửi dữ liệu UDP dạng binary
-/// Đồng thời hiển thị video stream từ ESP32-CAM.
-class ControlPage extends StatefulWidget {
-  final UdpService udpService;
-  final String cameraIp;
-  final int cameraPort;
-  const ControlPage({
-    super.key,
-    required this.udpService,
-    required this.cameraIp,
-    required this.cameraPort,
-  });
-
-  @override
-  State<ControlPage> createState() => _ControlPageState();
-}
-
-class _ControlPageState extends State<ControlPage> {
-  // Tọa độ joystick (x: trái-phải, y: dưới-lên)
-  double _joystick1X = 0.0;
-  double _joystick1Y = 0.0;
-  bool nitro = false;
-
-  // Giới hạn log hiển thị là 2 dòng
-  final List<String> _consoleLogs = [];
-  final ScrollController _scrollController = ScrollController();
-  static const int _maxLogs = 2;
-
-  void _addLog(String log) {
-    setState(() {
-      if (_consoleLogs.length >= _maxLogs) {
-        _consoleLogs.removeAt(0);
-      }
-      _consoleLogs.add(log);
-      WidgetsBinding.instance.addPostFrameCallback((_) {
-        if (_scrollController.hasClients) {
-          _scrollController.jumpTo(_scrollController.position.maxScrollExtent);
-        }
-      });
-    });
-  }
-
-  /// Hàm gửi dữ liệu UDP dạng binary:
-  /// Gói dữ liệu gồm 6 bytes: 2 byte cho j1X, 2 byte cho j1Y, 2 byte cho speed (nitro).
-  void _sendUdpData() {
-    int j1X = (_joystick1X * 100).round();
-    int j1Y = (-_joystick1Y * 100).round();
-    int speed = nitro ? 100 : 0;
-
-    ByteData bd = ByteData(6);
-    bd.setInt16(0, j1X, Endian.little);
-    bd.setInt16(2, j1Y, Endian.little);
-    bd.setInt16(4, speed, Endian.little);
-
-    Uint8List data = bd.buffer.asUint8List();
-    widget.udpService.sendData(data);
-    _addLog('j1X=$j1X, j1Y=$j1Y, spd=$speed');
-  }
-
-  // Khi nhấn giữ nút Nitro: bật nitro và gửi dữ liệu UDP
-  void _onNitroPress() {
-    setState(() {
-      nitro = true;
-    });
-    _addLog('Nitro on');
-    _sendUdpData();
-  }
-
-  // Khi nhả nút Nitro: tắt nitro và gửi dữ liệu UDP
-  void _onNitroRelease() {
-    setState(() {
-      nitro = false;
-    });
-    _addLog('Nitro off');
-    _sendUdpData();
-  }
-
-  @override
-  void dispose() {
-    widget.udpService.close();
-    _scrollController.dispose();
-    super.dispose();
-  }
-
-  @override
-  Widget build(BuildContext context) {
-    return Scaffold(
-      // Thu nhỏ AppBar xuống 50% so với chiều cao mặc định
-      appBar: PreferredSize(
-        preferredSize: const Size.fromHeight(28),
-        child: AppBar(
-          title: const Text('Điều khiển', style: TextStyle(fontSize: 16)),
-          actions: [
-            IconButton(
-              icon: const Icon(Icons.settings, size: 16),
-              tooltip: 'Quay lại cài đặt',
-              onPressed: () {
-                Navigator.pushReplacement(
-                  context,
-                  MaterialPageRoute(
-                    builder: (context) => const SettingsPage(),
-                  ),
-                );
-              },
-            ),
-          ],
-        ),
-      ),
-      body: Container(
-        decoration: const BoxDecoration(
-          gradient: LinearGradient(
-            colors: [Colors.blueGrey, Colors.black],
-            begin: Alignment.topLeft,
-            end: Alignment.bottomRight,
-          ),
-        ),
-        child: Stack(
-          children: [
-            // Video stream được căn giữa màn hình và dịch sang bên phải (offset 30)
-            Center(
-              child: Transform.translate(
-                offset: const Offset(30, 0),
-                child: Container(
-                  width: 300,
-                  height: 300,
-                  decoration: BoxDecoration(
-                    border: Border.all(color: Colors.white, width: 2),
-                    borderRadius: BorderRadius.circular(10),
-                  ),
-                  child: Mjpeg(
-                    stream:
-                    'http://${widget.cameraIp}:${widget.cameraPort}/stream',
-                    isLive: true,
-                    error: (context, error, stack) {
-                      return Center(
-                        child: Text(
-                          'Lỗi tải video: $error',
-                          style: const TextStyle(color: Colors.red),
-                        ),
-                      );
-                    },
-                  ),
-                ),
-              ),
-            ),
-            // Container chứa Joystick ở góc trái dưới màn hình
-            Positioned(
-              left: 20,
-              bottom: 20,
-              child: Container(
-                padding: const EdgeInsets.all(8.0),
-                decoration: BoxDecoration(
-                  color: Colors.white24,
-                  borderRadius: BorderRadius.circular(10),
-                ),
-                child: Joystick(
-                  mode: JoystickMode.all,
-                  listener: (details) {
-                    setState(() {
-                      _joystick1X = details.x;
-                      _joystick1Y = details.y;
-                    });
-                    _sendUdpData();
-                  },
-                ),
-              ),
-            ),
-            // Console log hiển thị ở phía trên màn hình với width cố định (250px)
-            Positioned(
-              top: 10,
-              left: 10,
-              child: SizedBox(
-                width: 250,
-                child: ConsoleLogWidget(
-                  logs: _consoleLogs,
-                  controller: _scrollController,
-                ),
-              ),
-            ),
-            // Nút tròn "Nitro" hiển thị ở góc dưới bên phải màn hình với cơ chế giữ
-            Positioned(
-              right: 20,
-              bottom: 20,
-              child: GestureDetector(
-                onTapDown: (_) => _onNitroPress(),
-                onTapUp: (_) => _onNitroRelease(),
-                onTapCancel: () => _onNitroRelease(),
-                child: FloatingActionButton(
-                  backgroundColor: nitro ? Colors.red : Colors.green,
-                  onPressed: () {},
-                  child: const Text(
-                    'Nitro',
-                    textAlign: TextAlign.center,
-                    style: TextStyle(fontSize: 16),
-                  ),
-                ),
-              ),
-            ),
-          ],
-        ),
-      ),
-    );
-  }
-}
-
-/// Widget ConsoleLogWidget nhận danh sách log động và ScrollController từ ControlPage
-class ConsoleLogWidget extends StatelessWidget {
-  final List<String> logs;
-  final ScrollController controller;
-  const ConsoleLogWidget({
-    super.key,
-    required this.logs,
-    required this.controller,
-  });
-
-  @override
-  Widget build(BuildContext context) {
-    return Container(
-      padding: const EdgeInsets.symmetric(horizontal: 10, vertical: 5),
-      decoration: BoxDecoration(
-        color: Colors.black54,
-        borderRadius: BorderRadius.circular(10),
-      ),
-      child: ListView.builder(
-        controller: controller,
-        shrinkWrap: true,
-        itemCount: logs.length,
-        itemBuilder: (context, index) {
-          return Text(
-            logs[index],
-            style: const TextStyle(color: Colors.white, fontSize: 12),
-          );
-        },
-      ),
-    );
-  }
-}
+import 'dart:async';
+import 'dart:io';
+import 'dart:typed_data';
+import 'package:flutter/material.dart';
+import 'package:flutter/services.dart';
+import 'package:flutter_joystick/flutter_joystick.dart';
+import 'package:flutter_mjpeg/flutter_mjpeg.dart';
+
+/// Dịch vụ UDP gửi dữ liệu dạng binary (header v1 + 6 bytes: 2 byte cho j1X, 2 byte cho j1Y, 2 byte cho speed)
+class UdpService {
+  RawDatagramSocket? _socket;
+  InternetAddress _targetAddress = InternetAddress('192.168.1.100');
+  int _port = 65000;
+
+  // Callback để gửi thông báo log lên giao diện
+  Function(String)? _logCallback;
+
+  // Callback nhận gói telemetry từ xe (gửi về chính socket này)
+  Function(TelemetryPacket)? onTelemetry;
+
+  UdpService({Function(String)? logCallback}) {
+    _logCallback = logCallback;
+  }
+
+  Future<void> init() async {
+    try {
+      _socket = await RawDatagramSocket.bind(InternetAddress.anyIPv4, 0);
+      _socket!.listen(_onSocketEvent);
+      _logCallback?.call('UDP socket initialized');
+    } catch (e) {
+      _logCallback?.call('Failed to initialize UDP socket: $e');
+    }
+  }
+
+  // Đọc hết các datagram đang chờ, chỉ quan tâm gói telemetry hợp lệ
+  void _onSocketEvent(RawSocketEvent event) {
+    if (event != RawSocketEvent.read) return;
+    Datagram? datagram;
+    while ((datagram = _socket?.receive()) != null) {
+      final packet = TelemetryPacket.tryParse(datagram!.data);
+      if (packet != null) {
+        onTelemetry?.call(packet);
+      }
+    }
+  }
+
+  void updateTarget(String ip, int port) {
+    try {
+      _targetAddress = InternetAddress(ip);
+      _port = port;
+      _logCallback?.call('Updated UDP target: IP=$_targetAddress, Port=$_port');
+    } catch (e) {
+      _logCallback?.call('Invalid IP or Port: $e');
+    }
+  }
+
+  // Header gói điều khiển v1 (xem control.h trên firmware)
+  static const int _magic = 0x4352; // 'R', 'C'
+  static const int _version = 1;
+  static const int _headerLength = 12;
+  static const int _payloadLength = 6;
+  // Cờ quyền điều khiển (CONTROL_FLAG_* trong control.h)
+  static const int _flagTakeover = 0x01;
+  static const int _flagRelease = 0x02;
+
+  // Gói kế tiếp sẽ giành quyền điều khiển từ điện thoại khác đang giữ xe
+  bool _takeover = false;
+
+  int _seq = 0;
+  final Stopwatch _clock = Stopwatch()..start();
+
+  // Gói điều khiển dùng lại cho mọi lần gửi, không cấp phát trên đường gửi
+  final Uint8List _packet = Uint8List(_headerLength + _payloadLength);
+  late final ByteData _packetData = ByteData.view(_packet.buffer);
+
+  /// Số gói đã gửi và số lần gửi thất bại, để log thưa thay vì log từng gói
+  int sentPackets = 0;
+  int sendErrors = 0;
+
+  /// Yêu cầu giành quyền điều khiển: gói kế tiếp mang cờ takeover
+  void requestTakeover() {
+    _takeover = true;
+  }
+
+  /// Trả quyền điều khiển cho điện thoại khác: gửi lệnh đứng yên kèm cờ release
+  void releaseControl() {
+    sendControl(0, 0, 0, flags: _flagRelease);
+  }
+
+  // Gửi gói v1: header {magic, version, flags, seq, sender_ms} để firmware loại
+  // gói trùng/sai thứ tự và đo jitter, rồi payload {j1X, j1Y, speed}.
+  // Chỉ log lần thất bại đầu tiên; phần còn lại được đếm trong sendErrors.
+  void sendControl(int j1X, int j1Y, int speed, {int flags = 0}) {
+    final socket = _socket;
+    if (socket == null) {
+      if (sendErrors++ == 0) _logCallback?.call('Socket is not initialized');
+      return;
+    }
+    if (_takeover) {
+      flags |= _flagTakeover;
+      _takeover = false;
+    }
+    final bd = _packetData;
+    bd.setUint16(0, _magic, Endian.little);
+    bd.setUint8(2, _version);
+    bd.setUint8(3, flags);
+    bd.setUint32(4, _seq, Endian.little);
+    bd.setUint32(8, _clock.elapsedMilliseconds & 0xFFFFFFFF, Endian.little);
+    bd.setInt16(_headerLength, j1X, Endian.little);
+    bd.setInt16(_headerLength + 2, j1Y, Endian.little);
+    bd.setInt16(_headerLength + 4, speed, Endian.little);
+    _seq = (_seq + 1) & 0xFFFFFFFF;
+
+    try {
+      // send() trả về 0 khi bộ đệm socket đầy: gói bị bỏ, gói sau mang trạng thái mới hơn
+      if (socket.send(_packet, _targetAddress, _port) > 0) {
+        sentPackets++;
+      } else {
+        sendErrors++;
+      }
+    } catch (e) {
+      if (sendErrors++ == 0) _logCallback?.call('Failed to send UDP data: $e');
+    }
+  }
+
+  void close() {
+    _socket?.close();
+    _socket = null;
+    _logCallback?.call('UDP socket closed');
+  }
+}
+
+/// Gói trạng thái xe gửi về (telemetry_packet_t trong telemetry.h),
+/// little endian, kích thước cố định [length] byte.
+class TelemetryPacket {
+  static const int magic = 0x5452; // 'R', 'T'
+  static const int version = 2;
+  static const int length = 64;
+
+  final int motorDirection;
+  final int seq;
+  final int uptimeMs;
+  final int motorDuty;
+  final int servoDuty;
+  final int controlSeq;
+  final int packetRate;
+  final int packets;
+  final int staleDropped;
+  final int dropped;
+  final int invalid;
+  final int loopUs;
+  final int loopMaxUs;
+  final int jitterUs;
+  final int freeHeap;
+  final int leaseRejected;
+  final int leaseChanges;
+
+  TelemetryPacket._(ByteData bd)
+      : motorDirection = bd.getInt8(3),
+        seq = bd.getUint32(4, Endian.little),
+        uptimeMs = bd.getUint32(8, Endian.little),
+        motorDuty = bd.getUint16(12, Endian.little),
+        servoDuty = bd.getUint16(14, Endian.little),
+        controlSeq = bd.getUint32(16, Endian.little),
+        packetRate = bd.getUint16(20, Endian.little),
+        packets = bd.getUint32(24, Endian.little),
+        staleDropped = bd.getUint32(28, Endian.little),
+        dropped = bd.getUint32(32, Endian.little),
+        invalid = bd.getUint32(36, Endian.little),
+        loopUs = bd.getUint32(40, Endian.little),
+        loopMaxUs = bd.getUint32(44, Endian.little),
+        jitterUs = bd.getUint32(48, Endian.little),
+        freeHeap = bd.getUint32(52, Endian.little),
+        leaseRejected = bd.getUint32(56, Endian.little),
+        leaseChanges = bd.getUint32(60, Endian.little);
+
+  /// Trả về null nếu không phải gói telemetry (sai độ dài, magic hoặc version)
+  static TelemetryPacket? tryParse(Uint8List data) {
+    if (data.length != length) return null;
+    final bd = ByteData.sublistView(data);
+    if (bd.getUint16(0, Endian.little) != magic || bd.getUint8(2) != version) {
+      return null;
+    }
+    return TelemetryPacket._(bd);
+  }
+
+  String get summary {
+    const dirs = {1: 'tiến', -1: 'lùi', 0: 'dừng'};
+    return 'motor ${dirs[motorDirection] ?? motorDirection} duty=$motorDuty servo=$servoDuty\n'
+        'rx $packetRate/s seq=$controlSeq stale=$staleDropped drop=$dropped bad=$invalid\n'
+        'loop ${loopUs}us (max ${loopMaxUs}us) jitter ${jitterUs}us heap ${freeHeap ~/ 1024}KB\n'
+        'lease rej=$leaseRejected chg=$leaseChanges';
+  }
+}
+
+void main() {
+  WidgetsFlutterBinding.ensureInitialized();
+  SystemChrome.setPreferredOrientations([
+    DeviceOrientation.landscapeLeft,
+    DeviceOrientation.landscapeRight,
+  ]).then((_) {
+    runApp(const MyApp());
+  });
+}
+
+class MyApp extends StatelessWidget {
+  const MyApp({super.key});
+  @override
+  Widget build(BuildContext context) {
+    return MaterialApp(
+      title: 'UDP Controller',
+      debugShowCheckedModeBanner: false,
+      home: const SettingsPage(),
+    );
+  }
+}
+
+/// Trang cài đặt để nhập địa chỉ IP, cổng UDP và cài đặt Camera
+class SettingsPage extends StatefulWidget {
+  const SettingsPage({super.key});
+  @override
+  State<SettingsPage> createState() => _SettingsPageState();
+}
+
+class _SettingsPageState extends State<SettingsPage> {
+  late final UdpService _udpService;
+  final TextEditingController _ipController =
+  TextEditingController(text: '192.168.1.100');
+  final TextEditingController _portController =
+  TextEditingController(text: '65000');
+
+  // Controller cho camera
+  final TextEditingController _cameraIpController =
+  TextEditingController(text: '192.168.1.101');
+  final TextEditingController _cameraPortController =
+  TextEditingController(text: '2003');
+
+  // Tần số gửi gói điều khiển (Hz)
+  final TextEditingController _sendRateController =
+  TextEditingController(text: '${ControlPage.defaultSendRateHz}');
+
+  @override
+  void initState() {
+    super.initState();
+    _udpService = UdpService(logCallback: (log) {
+      debugPrint(log);
+    });
+    _udpService.init();
+  }
+
+  @override
+  void dispose() {
+    _ipController.dispose();
+    _portController.dispose();
+    _cameraIpController.dispose();
+    _cameraPortController.dispose();
+    _sendRateController.dispose();
+    super.dispose();
+  }
+
+  void _saveUdpSettings() {
+    String ip = _ipController.text;
+    int port = int.tryParse(_portController.text) ?? 65000;
+    _udpService.updateTarget(ip, port);
+
+    // Lấy thông tin camera
+    String camIp = _cameraIpController.text;
+    int camPort = int.tryParse(_cameraPortController.text) ?? 80;
+    debugPrint('Camera settings: IP=$camIp, Port=$camPort');
+
+    int sendRate = (int.tryParse(_sendRateController.text) ??
+        ControlPage.defaultSendRateHz)
+        .clamp(ControlPage.minSendRateHz, ControlPage.maxSendRateHz);
+
+    Navigator.pushReplacement(
+      context,
+      MaterialPageRoute(
+        builder: (context) => ControlPage(
+          udpService: _udpService,
+          cameraIp: camIp,
+          cameraPort: camPort,
+          sendRateHz: sendRate,
+        ),
+      ),
+    );
+  }
+
+  @override
+  Widget build(BuildContext context) {
+    // Sử dụng SingleChildScrollView để tránh bottom overflow khi bàn phím xuất hiện.
+    return Scaffold(
+      appBar: AppBar(title: const Text('Cài đặt')),
+      body: SingleChildScrollView(
+        padding: const EdgeInsets.all(20.0),
+        child: ConstrainedBox(
+          constraints: BoxConstraints(
+            minHeight: MediaQuery.of(context).size.height -
+                kToolbarHeight -
+                MediaQuery.of(context).padding.top,
+          ),
+          child: IntrinsicHeight(
+            child: Column(
+              mainAxisAlignment: MainAxisAlignment.center,
+              children: [
+                // Hàng nhập liệu cho UDP: Địa chỉ IP và Cổng UDP
+                Row(
+                  children: [
+                    Expanded(
+                      child: TextField(
+                        controller: _ipController,
+                        decoration:
+                        const InputDecoration(labelText: 'Địa chỉ IP'),
+                      ),
+                    ),
+                    const SizedBox(width: 10),
+                    Expanded(
+                      child: TextField(
+                        controller: _portController,
+                        decoration:
+                        const InputDecoration(labelText: 'Cổng UDP'),
+                        keyboardType: TextInputType.number,
+                      ),
+                    ),
+                  ],
+                ),
+                const SizedBox(height: 20),
+                // Hàng nhập liệu cho Camera: Địa chỉ Camera và Cổng Camera
+                Row(
+                  children: [
+                    Expanded(
+                      child: TextField(
+                        controller: _cameraIpController,
+                        decoration: const InputDecoration(
+                            labelText: 'Địa chỉ Camera'),
+                      ),
+                    ),
+                    const SizedBox(width: 10),
+                    Expanded(
+                      child: TextField(
+                        controller: _cameraPortController,
+                        decoration: const InputDecoration(
+                            labelText: 'Cổng Camera'),
+                        keyboardType: TextInputType.number,
+                      ),
+                    ),
+                  ],
+                ),
+                const SizedBox(height: 20),
+                TextField(
+                  controller: _sendRateController,
+                  decoration: const InputDecoration(
+                      labelText: 'Tần số gửi (Hz)'),
+                  keyboardType: TextInputType.number,
+                ),
+                const SizedBox(height: 20),
+                ElevatedButton(
+                  onPressed: _saveUdpSettings,
+                  child: const Text('Lưu & Điều khiển'),
+                ),
+              ],
+            ),
+          ),
+        ),
+      ),
+    );
+  }
+}
+
+/// Trang điều khiển sử dụng Joystick để gửi dữ liệu UDP dạng binary
+/// Đồng thời hiển thị video stream từ ESP32-CAM.
+class ControlPage extends StatefulWidget {
+  final UdpService udpService;
+  final String cameraIp;
+  final int cameraPort;
+  // Tần số gửi gói điều khiển cố định
+  final int sendRateHz;
+  static const int defaultSendRateHz = 50;
+  static const int minSendRateHz = 10;
+  static const int maxSendRateHz = 100;
+  const ControlPage({
+    super.key,
+    required this.udpService,
+    required this.cameraIp,
+    required this.cameraPort,
+    this.sendRateHz = defaultSendRateHz,
+  });
+
+  @override
+  State<ControlPage> createState() => _ControlPageState();
+}
+
+class _ControlPageState extends State<ControlPage> {
+  // Trạng thái joystick mới nhất đã đổi sang đơn vị gửi (-100..100, y dương là tiến);
+  // listener chỉ cập nhật giá trị, việc gửi do vòng gửi tốc độ cố định đảm nhận
+  int _j1X = 0;
+  int _j1Y = 0;
+  bool nitro = false;
+  // Chế độ chạy chậm (profile PRECISION trên xe), bật/tắt bằng nút "Slow"
+  bool precision = false;
+
+  // Giới hạn log hiển thị là 2 dòng
+  final List<String> _consoleLogs = [];
+  final ScrollController _scrollController = ScrollController();
+  static const int _maxLogs = 2;
+
+  // Gói telemetry mới nhất từ xe
+  TelemetryPacket? _telemetry;
+
+  // Vòng gửi tốc độ cố định: mỗi chu kỳ gửi trạng thái mới nhất nếu có thay đổi,
+  // nếu không thì gửi lại (keep-alive) mỗi _keepAlivePeriod để failsafe trên xe
+  // không kích hoạt khi người lái giữ yên joystick
+  static const Duration _keepAlivePeriod = Duration(milliseconds: 100);
+  Timer? _sendTimer;
+  bool _dirty = true;
+  final Stopwatch _sinceSend = Stopwatch()..start();
+
+  // Log trạng thái gửi tối đa một lần mỗi _logPeriod thay vì mỗi gói
+  static const Duration _logPeriod = Duration(seconds: 1);
+  final Stopwatch _sinceLog = Stopwatch()..start();
+  int _sentAtLastLog = 0;
+
+  @override
+  void initState() {
+    super.initState();
+    _sendTimer = Timer.periodic(
+        Duration(microseconds: 1000000 ~/ widget.sendRateHz), (_) => _sendTick());
+    widget.udpService.onTelemetry = (packet) {
+      if (!mounted) return;
+      setState(() {
+        _telemetry = packet;
+      });
+    };
+  }
+
+  void _addLog(String log) {
+    setState(() {
+      if (_consoleLogs.length >= _maxLogs) {
+        _consoleLogs.removeAt(0);
+      }
+      _consoleLogs.add(log);
+      WidgetsBinding.instance.addPostFrameCallback((_) {
+        if (_scrollController.hasClients) {
+          _scrollController.jumpTo(_scrollController.position.maxScrollExtent);
+        }
+      });
+    });
+  }
+
+  /// speed chọn profile ga trên xe: 100 = nitro, -100 = chạy chậm, 0 = bình thường.
+  int get _speed => nitro ? 100 : (precision ? -100 : 0);
+
+  /// Một chu kỳ của vòng gửi: gói dữ liệu gồm 2 byte j1X, 2 byte j1Y, 2 byte speed
+  /// sau header v1, ghi vào bộ đệm dùng lại của UdpService.
+  void _sendTick() {
+    if (_dirty || _sinceSend.elapsed >= _keepAlivePeriod) {
+      _dirty = false;
+      _sinceSend.reset();
+      widget.udpService.sendControl(_j1X, _j1Y, _speed);
+    }
+
+    if (_sinceLog.elapsed >= _logPeriod) {
+      final sent = widget.udpService.sentPackets;
+      final rate = (sent - _sentAtLastLog) * 1000 ~/ _sinceLog.elapsedMilliseconds;
+      _sentAtLastLog = sent;
+      _sinceLog.reset();
+      _addLog('tx $rate/s j1X=$_j1X j1Y=$_j1Y spd=$_speed '
+          'err=${widget.udpService.sendErrors}');
+    }
+  }
+
+  // Trạng thái đổi: gửi ở chu kỳ kế tiếp của vòng gửi
+  void _markDirty() {
+    _dirty = true;
+  }
+
+  // Bật/tắt chế độ chạy chậm; nitro khi đang giữ vẫn được ưu tiên
+  void _onPrecisionToggle() {
+    setState(() {
+      precision = !precision;
+    });
+    _addLog(precision ? 'Slow on' : 'Slow off');
+    _markDirty();
+  }
+
+  // Khi nhấn giữ nút Nitro: bật nitro và gửi dữ liệu UDP
+  void _onNitroPress() {
+    setState(() {
+      nitro = true;
+    });
+    _addLog('Nitro on');
+    _markDirty();
+  }
+
+  // Khi nhả nút Nitro: tắt nitro và gửi dữ liệu UDP
+  void _onNitroRelease() {
+    setState(() {
+      nitro = false;
+    });
+    _addLog('Nitro off');
+    _markDirty();
+  }
+
+  @override
+  void dispose() {
+    _sendTimer?.cancel();
+    widget.udpService.releaseControl();
+    widget.udpService.onTelemetry = null;
+    widget.udpService.close();
+    _scrollController.dispose();
+    super.dispose();
+  }
+
+  @override
+  Widget build(BuildContext context) {
+    return Scaffold(
+      // Thu nhỏ AppBar xuống 50% so với chiều cao mặc định
+      appBar: PreferredSize(
+        preferredSize: const Size.fromHeight(28),
+        child: AppBar(
+          title: const Text('Điều khiển', style: TextStyle(fontSize: 16)),
+          actions: [
+            IconButton(
+              icon: const Icon(Icons.pan_tool, size: 16),
+              tooltip: 'Giành quyền điều khiển',
+              onPressed: () {
+                widget.udpService.requestTakeover();
+                _addLog('Takeover requested');
+                _markDirty();
+              },
+            ),
+            IconButton(
+              icon: const Icon(Icons.settings, size: 16),
+              tooltip: 'Quay lại cài đặt',
+              onPressed: () {
+                Navigator.pushReplacement(
+                  context,
+                  MaterialPageRoute(
+                    builder: (context) => const SettingsPage(),
+                  ),
+                );
+              },
+            ),
+          ],
+        ),
+      ),
+      body: Container(
+        decoration: const BoxDecoration(
+          gradient: LinearGradient(
+            colors: [Colors.blueGrey, Colors.black],
+            begin: Alignment.topLeft,
+            end: Alignment.bottomRight,
+          ),
+        ),
+        child: Stack(
+          children: [
+            // Video stream được căn giữa màn hình và dịch sang bên phải (offset 30)
+            Center(
+              child: Transform.translate(
+                offset: const Offset(30, 0),
+                child: Container(
+                  width: 300,
+                  height: 300,
+                  decoration: BoxDecoration(
+                    border: Border.all(color: Colors.white, width: 2),
+                    borderRadius: BorderRadius.circular(10),
+                  ),
+                  child: Mjpeg(
+                    stream:
+                    'http://${widget.cameraIp}:${widget.cameraPort}/stream',
+                    isLive: true,
+                    error: (context, error, stack) {
+                      return Center(
+                        child: Text(
+                          'Lỗi tải video: $error',
+                          style: const TextStyle(color: Colors.red),
+                        ),
+                      );
+                    },
+                  ),
+                ),
+              ),
+            ),
+            // Container chứa Joystick ở góc trái dưới màn hình
+            Positioned(
+              left: 20,
+              bottom: 20,
+              child: Container(
+                padding: const EdgeInsets.all(8.0),
+                decoration: BoxDecoration(
+                  color: Colors.white24,
+                  borderRadius: BorderRadius.circular(10),
+                ),
+                child: Joystick(
+                  mode: JoystickMode.all,
+                  listener: (details) {
+                    // Không setState: Joystick tự vẽ lại, chỉ vòng gửi dùng giá trị này
+                    _j1X = (details.x * 100).round();
+                    _j1Y = (-details.y * 100).round();
+                    _markDirty();
+                  },
+                ),
+              ),
+            ),
+            // Console log hiển thị ở phía trên màn hình với width cố định (250px)
+            Positioned(
+              top: 10,
+              left: 10,
+              child: SizedBox(
+                width: 250,
+                child: ConsoleLogWidget(
+                  logs: _consoleLogs,
+                  controller: _scrollController,
+                ),
+              ),
+            ),
+            // Trạng thái vòng điều khiển do xe gửi về, góc trên bên phải
+            if (_telemetry != null)
+              Positioned(
+                top: 10,
+                right: 10,
+                child: Container(
+                  padding:
+                  const EdgeInsets.symmetric(horizontal: 10, vertical: 5),
+                  decoration: BoxDecoration(
+                    color: Colors.black54,
+                    borderRadius: BorderRadius.circular(10),
+                  ),
+                  child: Text(
+                    _telemetry!.summary,
+                    style: const TextStyle(color: Colors.white, fontSize: 11),
+                  ),
+                ),
+              ),
+            // Nút tròn "Slow" bên trái nút Nitro, nhấn để bật/tắt chế độ chạy chậm
+            Positioned(
+              right: 90,
+              bottom: 20,
+              child: FloatingActionButton(
+                heroTag: 'slow',
+                backgroundColor: precision ? Colors.orange : Colors.grey,
+                onPressed: _onPrecisionToggle,
+                child: const Text(
+                  'Slow',
+                  textAlign: TextAlign.center,
+                  style: TextStyle(fontSize: 16),
+                ),
+              ),
+            ),
+            // Nút tròn "Nitro" hiển thị ở góc dưới bên phải màn hình với cơ chế giữ
+            Positioned(
+              right: 20,
+              bottom: 20,
+              child: GestureDetector(
+                onTapDown: (_) => _onNitroPress(),
+                onTapUp: (_) => _onNitroRelease(),
+                onTapCancel: () => _onNitroRelease(),
+                child: FloatingActionButton(
+                  backgroundColor: nitro ? Colors.red : Colors.green,
+                  onPressed: () {},
+                  child: const Text(
+                    'Nitro',
+                    textAlign: TextAlign.center,
+                    style: TextStyle(fontSize: 16),
+                  ),
+                ),
+              ),
+            ),
+          ],
+        ),
+      ),
+    );
+  }
+}
+
+/// Widget ConsoleLogWidget nhận danh sách log động và ScrollController từ ControlPage
+class ConsoleLogWidget extends StatelessWidget {
+  final List<String> logs;
+  final ScrollController controller;
+  const ConsoleLogWidget({
+    super.key,
+    required this.logs,
+    required this.controller,
+  });
+
+  @override
+  Widget build(BuildContext context) {
+    return Container(
+      padding: const EdgeInsets.symmetric(horizontal: 10, vertical: 5),
+      decoration: BoxDecoration(
+        color: Colors.black54,
+        borderRadius: BorderRadius.circular(10),
+      ),
+      child: ListView.builder(
+        controller: controller,
+        shrinkWrap: true,
+        itemCount: logs.length,
+        itemBuilder: (context, index) {
+          return Text(
+            logs[index],
+            style: const TextStyle(color: Colors.white, fontSize: 12),
+          );
+        },
+      ),
+    );
+  }
+}
@@ -0,0 +1,635 @@
+#include "control.h"
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <freertos/queue.h>
+#include <esp_log.h>
+#include "sdkconfig.h"
+#if CONFIG_IDF_TARGET_LINUX
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+#else
+#include <lwip/sockets.h>
+#endif
+#include "hal.h"
+#include "motor.h"
+#include "oled.h"
+#include "oled_widget.h"
+#include "latency.h"
+#include "failsafe.h"
+#include "sysmon.h"
+
+static const char *TAG = "control";
+
+// Task UDP dùng stack/TCB tĩnh nên chỉ tạo một lần và không bao giờ bị xóa:
+// start/stop chỉ mở/đóng socket, task chờ notify giữa hai lần kết nối
+TaskHandle_t udp_task_handle = NULL;
+static volatile bool udp_running = false; // Được yêu cầu nhận gói (start -> stop)
+static volatile bool udp_active = false;  // Task đang giữ socket mở
+
+// recvfrom thức dậy ít nhất một lần mỗi chu kỳ này để thấy yêu cầu dừng
+#define UDP_RECV_TIMEOUT_MS 100
+
+// Thống kê đường nhận -> điều khiển; chỉ UDP task ghi. Trường 64 bit có thể bị đọc
+// dở trên ESP32 nên được ghi và sao chép trong peer_lock
+static control_stats_t stats;
+
+// Người điều khiển gửi gói hợp lệ gần nhất (network byte order), dùng cho telemetry
+static portMUX_TYPE peer_lock = portMUX_INITIALIZER_UNLOCKED;
+static bool peer_valid = false;
+static uint32_t peer_addr;
+static uint16_t peer_port;
+
+// Slot của xe này trong gói đội xe (control_set_car_id)
+static volatile uint8_t car_id = CONTROL_CAR_ID_NONE;
+
+// Trạng thái hiển thị gửi từ UDP task sang display task
+typedef struct
+{
+    int16_t j1X;
+    int16_t j1Y;
+    int16_t angle;
+    int64_t recv_us;     // hal_time_us() lúc nhận gói, cho chặng LATENCY_DISPLAY (khác core)
+    uint32_t owner_addr; // Người giữ quyền điều khiển (network byte order), 0 nếu lease trống
+    uint16_t owner_port;
+    uint32_t lease_rejected;
+    uint32_t lease_changes;
+} display_state_t;
+
+// Các slot văn bản của màn hình trạng thái
+enum
+{
+    STATUS_SLOT_X,
+    STATUS_SLOT_Y,
+    STATUS_SLOT_ANGLE,
+    STATUS_SLOT_OWNER,
+    STATUS_SLOT_LEASE,
+};
+
+// Hộp thư 1 phần tử: giá trị mới nhất ghi đè giá trị cũ (xQueueOverwrite)
+static QueueHandle_t display_mailbox = NULL;
+TaskHandle_t display_task_handle = NULL;
+
+/*---------------------------------------------------------------
+ * Display task:
+ * Lấy trạng thái mới nhất từ display_mailbox và vẽ lên OLED,
+ * giới hạn tối đa DISPLAY_REFRESH_HZ lần/giây. oled_display() chỉ submit
+ * khung, việc truyền I2C do worker của oled.c đảm nhận.
+ *--------------------------------------------------------------*/
+void display_task(void *pvParameters)
+{
+    const TickType_t period = pdMS_TO_TICKS(1000 / DISPLAY_REFRESH_HZ);
+    display_state_t state;
+    uint32_t status_generation = oled_get_generation() - 1;
+
+    oled_widget_bind(STATUS_SLOT_X, 0, 0, OLED_WIDGET_MAX_CHARS);
+    oled_widget_bind(STATUS_SLOT_Y, 0, 1, OLED_WIDGET_MAX_CHARS);
+    oled_widget_bind(STATUS_SLOT_ANGLE, 0, 3, OLED_WIDGET_MAX_CHARS);
+    oled_widget_bind(STATUS_SLOT_OWNER, 0, 2, OLED_WIDGET_MAX_CHARS);
+    oled_widget_bind(STATUS_SLOT_LEASE, 0, 4, OLED_WIDGET_MAX_CHARS);
+
+    while (1)
+    {
+        if (xQueueReceive(display_mailbox, &state, portMAX_DELAY) != pdTRUE)
+            continue;
+
+        TickType_t frame_start = xTaskGetTickCount();
+
+        // Màn hình đang hiển thị nội dung khác (IP, provisioning...): xóa một lần rồi vẽ lại từ đầu
+        if (oled_get_generation() != status_generation)
+        {
+            oled_clear();
+            status_generation = oled_get_generation();
+        }
+        // Các slot chỉ vẽ lại những ký tự thay đổi
+        oled_widget_printf(STATUS_SLOT_X, "x = %d", state.j1X);
+        oled_widget_printf(STATUS_SLOT_Y, "y = %d", state.j1Y);
+        oled_widget_printf(STATUS_SLOT_ANGLE, "angle = %d", state.angle);
+        // Chỉ octet cuối của IP để vừa một dòng cùng cổng (nhiều app trên cùng máy khác cổng)
+        const uint8_t *owner = (const uint8_t *)&state.owner_addr;
+        if (state.owner_addr == 0)
+            oled_widget_printf(STATUS_SLOT_OWNER, "own -");
+        else
+            oled_widget_printf(STATUS_SLOT_OWNER, "own .%u:%u", owner[3], ntohs(state.owner_port));
+        oled_widget_printf(STATUS_SLOT_LEASE, "rej %lu chg %lu",
+                           (unsigned long)state.lease_rejected, (unsigned long)state.lease_changes);
+        oled_display();
+        LATENCY_RECORD_US(LATENCY_DISPLAY, state.recv_us);
+        latency_collect();
+
+        // Chờ hết chu kỳ làm mới; các gói đến trong lúc này chỉ giữ lại giá trị cuối
+        vTaskDelayUntil(&frame_start, period);
+    }
+}
+
+/*---------------------------------------------------------------
+ * Khởi tạo hộp thư và display task (chỉ tạo một lần)
+ *--------------------------------------------------------------*/
+SYSMON_QUEUE_STORAGE(display, 1, sizeof(display_state_t));
+SYSMON_TASK_STORAGE(display, TASK_DISPLAY_STACK);
+
+void start_display_task(void)
+{
+    if (display_task_handle == NULL)
+    {
+        display_mailbox = SYSMON_QUEUE_CREATE(display, 1, sizeof(display_state_t));
+        SYSMON_TASK_CREATE(display, display_task, "display", NULL, TASK_DISPLAY_PRIO, TASK_DISPLAY_CORE, &display_task_handle);
+        ESP_LOGI(TAG, "Display task started (%d Hz)", DISPLAY_REFRESH_HZ);
+    }
+}
+
+// Ghi lại thời gian từ lúc recvfrom trả về đến khi servo/motor đã được cập nhật
+static void control_record_latency(int64_t latency_us)
+{
+    portENTER_CRITICAL(&peer_lock);
+    stats.packets++;
+    stats.last_latency_us = latency_us;
+    if (latency_us > stats.max_latency_us)
+        stats.max_latency_us = latency_us;
+    portEXIT_CRITICAL(&peer_lock);
+}
+
+void control_get_stats(control_stats_t *out)
+{
+    portENTER_CRITICAL(&peer_lock);
+    *out = stats;
+    portEXIT_CRITICAL(&peer_lock);
+}
+
+static void control_set_peer(const struct sockaddr_in *from)
+{
+    portENTER_CRITICAL(&peer_lock);
+    peer_addr = from->sin_addr.s_addr;
+    peer_port = from->sin_port;
+    peer_valid = true;
+    portEXIT_CRITICAL(&peer_lock);
+}
+
+esp_err_t control_set_car_id(uint8_t id)
+{
+    if (id >= CONTROL_FLEET_MAX && id != CONTROL_CAR_ID_NONE)
+        return ESP_ERR_INVALID_ARG;
+    car_id = id;
+    return ESP_OK;
+}
+
+uint8_t control_get_car_id(void)
+{
+    return car_id;
+}
+
+bool control_get_peer(uint32_t *addr, uint16_t *port)
+{
+    portENTER_CRITICAL(&peer_lock);
+    bool valid = peer_valid;
+    *addr = peer_addr;
+    *port = peer_port;
+    portEXIT_CRITICAL(&peer_lock);
+    return valid;
+}
+
+// Một lệnh điều khiển đã giải mã từ gói UDP
+typedef struct
+{
+    bool has_seq;       // false với gói legacy 6 byte
+    uint8_t flags;      // CONTROL_FLAG_*, 0 với gói legacy
+    uint32_t seq;
+    uint32_t sender_ms;
+    int16_t j1X;
+    int16_t j1Y;
+    int16_t speed;
+} control_cmd_t;
+
+// Trạng thái thứ tự gói của người gửi hiện tại
+static struct
+{
+    bool valid;
+    uint32_t addr;       // Địa chỉ + cổng nguồn; đổi nguồn thì bắt đầu lại từ đầu
+    uint16_t port;
+    uint32_t last_seq;
+    int64_t last_transit_us;
+    uint32_t jitter_q4;  // Jitter RFC 3550 (us), nhân 16 để giữ phần lẻ
+} seq_state;
+
+// Quyền điều khiển; chỉ UDP task đọc/ghi. Người giữ quyền được công bố qua
+// control_set_peer() sau khi gói của họ được áp dụng.
+static struct
+{
+    bool held;
+    uint32_t addr;       // Địa chỉ + cổng nguồn của chủ sở hữu (network byte order)
+    uint16_t port;
+    int64_t expires_us;  // Gia hạn mỗi khi chủ sở hữu gửi gói hợp lệ
+} lease;
+
+typedef enum
+{
+    CONTROL_PARSE_INVALID,   // Sai độ dài, magic hoặc version
+    CONTROL_PARSE_OK,
+    CONTROL_PARSE_OTHER_CAR, // Gói đội xe không có slot cho xe này
+} control_parse_t;
+
+// Giải mã gói v1 (CONTROL_V1_LEN byte), gói đội xe hoặc gói legacy 6 byte
+static control_parse_t control_parse(const char *buffer, int len, control_cmd_t *cmd)
+{
+    const char *payload;
+    if (len == CONTROL_LEGACY_LEN)
+    {
+        cmd->has_seq = false;
+        cmd->flags = 0;
+        payload = buffer;
+    }
+    else if (len >= CONTROL_HEADER_LEN)
+    {
+        uint16_t magic;
+        memcpy(&magic, buffer, 2);
+        if ((uint8_t)buffer[2] != CONTROL_VERSION)
+            return CONTROL_PARSE_INVALID;
+        if (magic == CONTROL_MAGIC && len == CONTROL_V1_LEN)
+        {
+            payload = buffer + CONTROL_HEADER_LEN;
+        }
+        else if (magic == CONTROL_FLEET_MAGIC && (len - CONTROL_HEADER_LEN) % CONTROL_LEGACY_LEN == 0)
+        {
+            // Đọc thẳng slot của xe này, không duyệt các slot khác
+            uint8_t id = car_id;
+            if (id == CONTROL_CAR_ID_NONE || len < CONTROL_FLEET_LEN(id + 1))
+                return CONTROL_PARSE_OTHER_CAR;
+            payload = buffer + CONTROL_FLEET_LEN(id);
+        }
+        else
+        {
+            return CONTROL_PARSE_INVALID;
+        }
+        cmd->has_seq = true;
+        cmd->flags = (uint8_t)buffer[3];
+        memcpy(&cmd->seq, buffer + 4, 4);
+        memcpy(&cmd->sender_ms, buffer + 8, 4);
+    }
+    else
+    {
+        return CONTROL_PARSE_INVALID;
+    }
+    memcpy(&cmd->j1X, payload, 2);
+    memcpy(&cmd->j1Y, payload + 2, 2);
+    memcpy(&cmd->speed, payload + 4, 2);
+    return CONTROL_PARSE_OK;
+}
+
+// Chỉ nhận lệnh từ người đang giữ quyền, hoặc từ nguồn mới khi lease trống, hết hạn
+// hoặc gói có CONTROL_FLAG_TAKEOVER. Không đổi lease: quyền chỉ được trao (và gia hạn)
+// bởi control_lease_commit() sau khi gói qua được kiểm tra seq. Gói bị loại được đếm
+// vào stats.lease_rejected.
+static bool control_lease_check(const control_cmd_t *cmd, const struct sockaddr_in *from, int64_t t_recv)
+{
+    bool owner = lease.held && lease.addr == from->sin_addr.s_addr && lease.port == from->sin_port;
+    bool expired = !lease.held || t_recv >= lease.expires_us;
+    if (owner || expired || (cmd->flags & CONTROL_FLAG_TAKEOVER))
+        return true;
+    stats.lease_rejected++;
+    return false;
+}
+
+// Gói đã được nhận: trao quyền nếu người gửi chưa giữ, gia hạn lease, rồi xử lý
+// CONTROL_FLAG_RELEASE ngay tại gói này để gói của người khác phía sau trong cùng
+// lần rút hàng đợi nhận được quyền
+static void control_lease_commit(const control_cmd_t *cmd, const struct sockaddr_in *from, int64_t t_recv)
+{
+    bool owner = lease.held && lease.addr == from->sin_addr.s_addr && lease.port == from->sin_port;
+    if (!owner)
+    {
+        bool expired = !lease.held || t_recv >= lease.expires_us;
+        if (!expired)
+            stats.lease_takeovers++;
+        stats.lease_changes++;
+        ESP_LOGI(TAG, "Quyền điều khiển: %s:%u (%s)", inet_ntoa(from->sin_addr), ntohs(from->sin_port),
+                 !lease.held ? "lease trống" : (expired ? "lease hết hạn" : "giành quyền"));
+        lease.held = true;
+        lease.addr = from->sin_addr.s_addr;
+        lease.port = from->sin_port;
+    }
+    lease.expires_us = t_recv + (int64_t)CONTROL_LEASE_MS * 1000;
+
+    if (cmd->flags & CONTROL_FLAG_RELEASE)
+    {
+        lease.held = false;
+        ESP_LOGI(TAG, "Quyền điều khiển được trả lại");
+    }
+}
+
+// Loại gói trùng/đến sai thứ tự và cập nhật jitter theo RFC 3550 (mục 6.4.1).
+// Gói legacy không có seq nên luôn được nhận.
+static bool control_accept(const control_cmd_t *cmd, const struct sockaddr_in *from, int64_t t_recv)
+{
+    if (!cmd->has_seq)
+        return true;
+
+    if (!seq_state.valid || seq_state.addr != from->sin_addr.s_addr || seq_state.port != from->sin_port)
+    {
+        // Người gửi mới (hoặc app khởi động lại với socket mới)
+        seq_state.valid = true;
+        seq_state.addr = from->sin_addr.s_addr;
+        seq_state.port = from->sin_port;
+        seq_state.jitter_q4 = 0;
+    }
+    else
+    {
+        // So sánh theo số học modulo 2^32 để chịu được wrap của seq
+        int32_t delta = (int32_t)(cmd->seq - seq_state.last_seq);
+        if (delta == 0)
+        {
+            stats.duplicates++;
+            return false;
+        }
+        if (delta < 0)
+        {
+            stats.reordered++;
+            return false;
+        }
+
+        int64_t d = (t_recv - (int64_t)cmd->sender_ms * 1000) - seq_state.last_transit_us;
+        uint32_t abs_d = (uint32_t)(d < 0 ? -d : d);
+        // J += (|D| - J) / 16, tính trên J * 16
+        seq_state.jitter_q4 += abs_d - ((seq_state.jitter_q4 + 8) >> 4);
+    }
+
+    seq_state.last_seq = cmd->seq;
+    seq_state.last_transit_us = t_recv - (int64_t)cmd->sender_ms * 1000;
+    stats.last_seq = cmd->seq;
+    stats.jitter_us = seq_state.jitter_q4 >> 4;
+    return true;
+}
+
+// Áp dụng lệnh lên servo/motor rồi đẩy trạng thái sang display task
+static void control_apply(const control_cmd_t *cmd, int64_t t_recv, uint32_t recv_cycles)
+{
+    uint32_t t_stage = LATENCY_STAMP();
+    int angle = steering_angle(cmd->j1X, cmd->j1Y);
+    LATENCY_RECORD(LATENCY_STEER, t_stage);
+    ESP_LOGD(TAG, "Nhận dữ liệu: j1X=%d, j1Y=%d, speed=%d, angle=%d", cmd->j1X, cmd->j1Y, cmd->speed, angle);
+
+    // xe chạy motor quang ngân; giữ khóa để không xen với failsafe task
+    t_stage = LATENCY_STAMP();
+    motor_lock();
+    failsafe_notify_packet();
+    servo_set_angle(90 + angle);
+    motor_control(cmd->j1Y, cmd->speed);
+    motor_unlock();
+    LATENCY_RECORD(LATENCY_ACTUATE, t_stage);
+    LATENCY_RECORD(LATENCY_TOTAL, recv_cycles);
+    control_record_latency(hal_time_us() - t_recv);
+
+    static bool first_actuation = true;
+    if (first_actuation)
+    {
+        first_actuation = false;
+        ESP_LOGI(TAG, "Boot -> lần điều khiển đầu tiên: %lld ms", (long long)(hal_time_us() / 1000));
+    }
+
+    // Chỉ đẩy trạng thái sang display task, không chờ I2C
+    display_state_t state = {.j1X = cmd->j1X,
+                             .j1Y = cmd->j1Y,
+                             .angle = angle,
+                             .recv_us = t_recv,
+                             .owner_addr = lease.held ? lease.addr : 0,
+                             .owner_port = lease.held ? lease.port : 0,
+                             .lease_rejected = stats.lease_rejected,
+                             .lease_changes = stats.lease_changes};
+    xQueueOverwrite(display_mailbox, &state);
+}
+
+// Trả lời gói truy vấn (CONTROL_QUERY_LEN byte) bằng báo cáo độ trễ dạng văn bản,
+// gửi về đúng địa chỉ người hỏi; trả về false nếu không phải gói truy vấn
+static bool control_handle_query(int sock, const char *buffer, int len, const struct sockaddr_in *from)
+{
+    uint16_t magic;
+    if (len != CONTROL_QUERY_LEN)
+        return false;
+    memcpy(&magic, buffer, 2);
+    if (magic != CONTROL_QUERY_MAGIC || (uint8_t)buffer[2] != CONTROL_VERSION)
+        return false;
+
+    static char report[SYSMON_REPORT_LEN];
+    size_t n;
+    uint8_t cmd = (uint8_t)buffer[3];
+    if (cmd == CONTROL_QUERY_TASKS)
+    {
+        n = sysmon_format_tasks(report, sizeof(report));
+        sendto(sock, report, n, 0, (const struct sockaddr *)from, sizeof(*from));
+        return true;
+    }
+#if LATENCY_TRACE
+    if (cmd == CONTROL_QUERY_LATENCY_LOG)
+        latency_dump();
+    n = latency_format(report, sizeof(report));
+    if (cmd == CONTROL_QUERY_LATENCY_RESET)
+        latency_reset();
+#else
+    n = (size_t)snprintf(report, sizeof(report), "latency trace disabled\n");
+#endif
+    sendto(sock, report, n, 0, (const struct sockaddr *)from, sizeof(*from));
+    return true;
+}
+
+/*---------------------------------------------------------------
+ * UDP listener task:
+ * Nhận dữ liệu UDP dạng binary, little endian (xem control.h):
+ *   - v1 (18 byte): header 12 byte {magic, version, flags, seq, sender_ms}
+ *     rồi tới payload 6 byte
+ *   - legacy (6 byte): chỉ có payload
+ *   - đội xe (multicast CONTROL_FLEET_GROUP): header như v1 rồi tới một
+ *     payload 6 byte cho mỗi car ID, xe chỉ đọc slot của mình
+ * Payload:
+ *   - 2 byte: j1X (int16_t)
+ *   - 2 byte: j1Y (int16_t)
+ *   - 2 byte: speed (int16_t), chọn profile ga (xem throttle_select)
+ * Điều khiển motor theo giá trị j1X (dương: quay thuận, âm: quay nghịch)
+ *
+ * Mỗi lần thức dậy, task đọc hết các gói đang chờ trong socket (không chặn,
+ * tối đa CONTROL_DRAIN_MAX gói) và chỉ áp dụng gói hợp lệ mới nhất; các gói
+ * cũ hơn được tính vào stats.stale_dropped. Gói v1 trùng seq hoặc đến sai
+ * thứ tự bị loại trước khi xét.
+ *
+ * Chỉ người giữ quyền điều khiển (lease, xem control.h) được áp dụng lệnh;
+ * gói từ nguồn khác bị đếm vào stats.lease_rejected và bỏ qua.
+ *
+ * Gói truy vấn CONTROL_QUERY_LEN byte được trả lời ngay bằng báo cáo độ trễ
+ * từng chặng (latency.h) hoặc bảng task (sysmon.h), không ảnh hưởng tới điều khiển.
+ *--------------------------------------------------------------*/
+
+// Mở socket và nhận gói cho tới khi stop_udp_task() xóa udp_running;
+// trả về false nếu không mở được socket
+static bool udp_serve(void)
+{
+    int sock = -1;
+    struct sockaddr_in server_addr;
+
+    sock = socket(AF_INET, SOCK_DGRAM, IPPROTO_IP);
+    if (sock < 0)
+    {
+        ESP_LOGE(TAG, "Không thể tạo socket");
+        return false;
+    }
+
+    struct timeval timeout = {.tv_sec = 0, .tv_usec = UDP_RECV_TIMEOUT_MS * 1000};
+    setsockopt(sock, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+
+#if CONFIG_IDF_TARGET_LINUX && CONTROL_FLEET
+    // Cho phép chạy nhiều xe giả lập trên cùng máy, cùng nhận gói đội xe
+    int reuse = 1;
+    setsockopt(sock, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+#endif
+
+    server_addr.sin_family = AF_INET;
+    server_addr.sin_port = htons(UDP_PORT);
+    server_addr.sin_addr.s_addr = htonl(INADDR_ANY);
+
+    if (bind(sock, (struct sockaddr *)&server_addr, sizeof(server_addr)) < 0)
+    {
+        ESP_LOGE(TAG, "Không thể bind socket: %d", errno);
+        close(sock);
+        return false;
+    }
+
+#if CONTROL_FLEET
+    struct ip_mreq mreq = {0};
+    mreq.imr_multiaddr.s_addr = inet_addr(CONTROL_FLEET_GROUP);
+    mreq.imr_interface.s_addr = htonl(INADDR_ANY);
+    if (setsockopt(sock, IPPROTO_IP, IP_ADD_MEMBERSHIP, &mreq, sizeof(mreq)) < 0)
+        ESP_LOGW(TAG, "Không tham gia được nhóm đội xe %s: %d", CONTROL_FLEET_GROUP, errno);
+    else
+        ESP_LOGI(TAG, "Nhóm đội xe %s, car ID %d", CONTROL_FLEET_GROUP,
+                 car_id == CONTROL_CAR_ID_NONE ? -1 : (int)car_id);
+#endif
+
+    udp_active = true;
+    lease.held = false;
+    ESP_LOGI(TAG, "Bắt đầu UDP listener trên cổng %d", UDP_PORT);
+
+    char buffer[CONTROL_FLEET_LEN(CONTROL_FLEET_MAX)];
+    struct sockaddr_in source_addr;
+    socklen_t socklen;
+
+    while (udp_running)
+    {
+        // Chờ gói đầu tiên (chặn)
+        socklen = sizeof(source_addr);
+        int len = recvfrom(sock, buffer, sizeof(buffer), 0,
+                           (struct sockaddr *)&source_addr, &socklen);
+        if (len < 0)
+        {
+            if (udp_running && errno != EAGAIN && errno != EWOULDBLOCK)
+                ESP_LOGE(TAG, "Lỗi nhận UDP: %d", errno);
+            continue;
+        }
+
+        // Rút cạn hàng đợi socket, chỉ giữ lệnh hợp lệ mới nhất
+        control_cmd_t cmd, latest;
+        struct sockaddr_in latest_from;
+        uint32_t valid = 0;
+        int64_t t_recv = 0;
+        uint32_t recv_cycles = 0;
+        for (int n = 1;; n++)
+        {
+            int64_t t = hal_time_us();
+            uint32_t c = LATENCY_STAMP();
+            // Gói truy vấn được trả lời ngay, không phải lệnh điều khiển
+            if (!control_handle_query(sock, buffer, len, &source_addr))
+            {
+                control_parse_t parsed = control_parse(buffer, len, &cmd);
+                if (parsed == CONTROL_PARSE_INVALID)
+                {
+                    stats.invalid++;
+                    ESP_LOGW(TAG, "Dữ liệu không hợp lệ: %d bytes", len);
+                }
+                else if (parsed == CONTROL_PARSE_OTHER_CAR)
+                {
+                    stats.fleet_ignored++;
+                }
+                else if (control_lease_check(&cmd, &source_addr, t) &&
+                         control_accept(&cmd, &source_addr, t))
+                {
+                    // Gói trùng/sai thứ tự không trao hay gia hạn quyền
+                    control_lease_commit(&cmd, &source_addr, t);
+                    latest = cmd;
+                    latest_from = source_addr;
+                    t_recv = t;
+                    recv_cycles = c;
+                    valid++;
+                    LATENCY_RECORD(LATENCY_PARSE, c);
+                }
+            }
+
+            if (n >= CONTROL_DRAIN_MAX)
+                break;
+            socklen = sizeof(source_addr);
+            len = recvfrom(sock, buffer, sizeof(buffer), MSG_DONTWAIT,
+                           (struct sockaddr *)&source_addr, &socklen);
+            if (len < 0)
+                break; // EWOULDBLOCK: không còn gói nào đang chờ
+        }
+
+        if (valid == 0)
+            continue;
+        stats.stale_dropped += valid - 1;
+        control_apply(&latest, t_recv, recv_cycles);
+        control_set_peer(&latest_from);
+    }
+
+    close(sock);
+    ESP_LOGI(TAG, "Đóng socket UDP");
+    oled_clear();
+    oled_print(0, 5, "close Socket UDP");
+    oled_display();
+    udp_active = false;
+    return true;
+}
+
+void udp_listener_task(void *pvParameters)
+{
+    for (;;)
+    {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        if (!udp_running)
+            continue;
+        // Lỗi socket: chờ lần start_udp_task() kế tiếp (lần có IP sau) để thử lại
+        if (!udp_serve())
+            udp_running = false;
+    }
+}
+
+/*---------------------------------------------------------------
+ * Khởi tạo task UDP listener (lần đầu) và bắt đầu nhận gói
+ *--------------------------------------------------------------*/
+SYSMON_TASK_STORAGE(udp, TASK_UDP_STACK);
+
+void start_udp_task(void)
+{
+    if (udp_running)
+        return;
+    udp_running = true;
+    if (udp_task_handle == NULL)
+        SYSMON_TASK_CREATE(udp, udp_listener_task, "udp_listener", NULL, TASK_UDP_PRIO, TASK_UDP_CORE, &udp_task_handle);
+    xTaskNotifyGive(udp_task_handle);
+    ESP_LOGI(TAG, "UDP task started");
+}
+
+/*---------------------------------------------------------------
+ * Dừng nhận gói; task ở lại chờ lần start_udp_task() sau
+ *--------------------------------------------------------------*/
+void stop_udp_task(void)
+{
+    if (!udp_running)
+        return;
+    udp_running = false;
+    portENTER_CRITICAL(&peer_lock);
+    peer_valid = false;
+    portEXIT_CRITICAL(&peer_lock);
+    // Chờ task đóng socket (tối đa vài chu kỳ UDP_RECV_TIMEOUT_MS) để lần start sau mở lại được cổng
+    for (int waited = 0; udp_active && waited < 3 * UDP_RECV_TIMEOUT_MS; waited += 10)
+        vTaskDelay(pdMS_TO_TICKS(10));
+    ESP_LOGI(TAG, "UDP task stopped");
+}
@@ -0,0 +1,149 @@
+#ifndef CONTROL_H
+#define CONTROL_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <esp_err.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#define UDP_PORT 65000
+#define DISPLAY_REFRESH_HZ 10 // Tần số làm mới tối đa của màn OLED
+
+/*
+ * Gói điều khiển v1, little endian:
+ *   0  u16 magic      CONTROL_MAGIC ("RC")
+ *   2  u8  version    CONTROL_VERSION
+ *   3  u8  flags      CONTROL_FLAG_*, các bit khác gửi 0
+ *   4  u32 seq        tăng 1 mỗi gói, được phép wrap
+ *   8  u32 sender_ms  đồng hồ của người gửi (ms, gốc tùy ý)
+ *   12 i16 j1X, i16 j1Y, i16 speed
+ * Gói legacy chỉ gồm 6 byte payload, không có header.
+ */
+#define CONTROL_MAGIC 0x4352 // 'R', 'C'
+#define CONTROL_VERSION 1
+#define CONTROL_HEADER_LEN 12
+#define CONTROL_LEGACY_LEN 6
+#define CONTROL_V1_LEN (CONTROL_HEADER_LEN + CONTROL_LEGACY_LEN)
+
+/*
+ * Gói đội xe (fleet), gửi một lần tới nhóm multicast CONTROL_FLEET_GROUP:UDP_PORT
+ * để lái nhiều xe, little endian:
+ *   0  u16 magic      CONTROL_FLEET_MAGIC ("RF")
+ *   2  u8  version, 3 u8 flags, 4 u32 seq, 8 u32 sender_ms  như gói v1
+ *   12 N slot 6 byte {i16 j1X, i16 j1Y, i16 speed}, slot k dành cho xe có car ID k
+ * N suy ra từ độ dài gói. Mỗi xe chỉ đọc slot của mình tại
+ * CONTROL_HEADER_LEN + car_id * CONTROL_LEGACY_LEN; gói không đủ dài để chứa slot
+ * đó, hoặc xe chưa có car ID, bị bỏ qua (stats.fleet_ignored). Sau khi giải mã,
+ * slot được xử lý như một gói v1 (seq, lease, failsafe).
+ */
+#ifndef CONTROL_FLEET
+#define CONTROL_FLEET 1 // 0: không tham gia nhóm multicast
+#endif
+#define CONTROL_FLEET_MAGIC 0x4652 // 'R', 'F'
+#define CONTROL_FLEET_GROUP "239.255.65.0"
+#define CONTROL_FLEET_MAX 32       // Số car ID tối đa (0 -> CONTROL_FLEET_MAX-1)
+#define CONTROL_FLEET_LEN(n) (CONTROL_HEADER_LEN + (n) * CONTROL_LEGACY_LEN)
+#define CONTROL_CAR_ID_NONE 0xFF
+
+/*
+ * Quyền điều khiển (lease): người gửi đầu tiên giữ xe; gói điều khiển từ địa chỉ/cổng
+ * khác bị loại (stats.lease_rejected) cho tới khi chủ sở hữu im lặng quá
+ * CONTROL_LEASE_MS, trả quyền bằng CONTROL_FLAG_RELEASE, hoặc người gửi khác đặt
+ * CONTROL_FLAG_TAKEOVER (giành quyền chủ động). Gói legacy không có cờ nên chỉ
+ * nhận quyền được khi lease trống hoặc hết hạn.
+ */
+#ifndef CONTROL_LEASE_MS
+#define CONTROL_LEASE_MS 1500 // Lớn hơn brake_ms của failsafe: xe đã dừng khi quyền được trao lại
+#endif
+#define CONTROL_FLAG_TAKEOVER 0x01 // Giành quyền từ chủ sở hữu hiện tại
+#define CONTROL_FLAG_RELEASE 0x02  // Chủ sở hữu trả quyền; lệnh trong chính gói này vẫn được nhận
+
+/*
+ * Gói truy vấn, little endian: u16 CONTROL_QUERY_MAGIC ("RQ"), u8 CONTROL_VERSION,
+ * u8 lệnh. Xe trả lời về người hỏi bằng báo cáo dạng văn bản: độ trễ từng chặng
+ * (latency.h) hoặc bảng task (sysmon.h).
+ */
+#define CONTROL_QUERY_MAGIC 0x5152 // 'R', 'Q'
+#define CONTROL_QUERY_LEN 4
+#define CONTROL_QUERY_LATENCY 0       // Chỉ gửi báo cáo
+#define CONTROL_QUERY_LATENCY_RESET 1 // Gửi báo cáo rồi xóa histogram
+#define CONTROL_QUERY_LATENCY_LOG 2   // Gửi báo cáo và in ra log
+#define CONTROL_QUERY_TASKS 3         // Gửi bảng task: core, ưu tiên, % CPU, stack (sysmon)
+
+#define CONTROL_DRAIN_MAX 32   // Số gói tối đa đọc trong một lần thức dậy của UDP task
+
+    /**
+     * @brief Thống kê đường nhận gói UDP -> cập nhật servo/motor.
+     */
+    typedef struct
+    {
+        uint32_t packets;       // Số gói điều khiển đã áp dụng
+        int64_t last_latency_us; // Thời gian recvfrom -> actuation của gói gần nhất (us)
+        int64_t max_latency_us;  // Giá trị lớn nhất kể từ khi khởi động (us)
+        uint32_t stale_dropped;  // Gói hợp lệ bị bỏ qua vì đã có gói mới hơn trong cùng lần đọc
+        uint32_t invalid;        // Gói sai độ dài, magic hoặc version
+        uint32_t duplicates;     // Gói v1 trùng seq với gói đã nhận
+        uint32_t reordered;      // Gói v1 có seq cũ hơn gói đã nhận
+        uint32_t last_seq;       // Seq của gói v1 được nhận gần nhất
+        uint32_t jitter_us;      // Jitter thời gian đến theo RFC 3550 (us)
+        uint32_t lease_rejected; // Gói điều khiển từ nguồn không giữ quyền bị loại
+        uint32_t lease_changes;  // Số lần quyền điều khiển đổi chủ (kể cả lần nhận đầu tiên)
+        uint32_t lease_takeovers; // Trong đó: giành quyền bằng CONTROL_FLAG_TAKEOVER khi lease còn hạn
+        uint32_t fleet_ignored;  // Gói đội xe không có slot cho xe này
+    } control_stats_t;
+
+    /**
+     * @brief Tạo hộp thư và display task vẽ màn hình trạng thái (chỉ tạo một lần).
+     */
+    void start_display_task(void);
+
+    /**
+     * @brief Mở socket nhận gói điều khiển UDP trên cổng UDP_PORT.
+     *
+     * Task được tạo ở lần gọi đầu tiên và giữ lại suốt; các lần sau chỉ đánh thức nó.
+     */
+    void start_udp_task(void);
+
+    /**
+     * @brief Đóng socket nhận gói điều khiển UDP; chờ task đóng xong rồi mới trả về.
+     */
+    void stop_udp_task(void);
+
+    /**
+     * @brief Lấy thống kê đường nhận -> điều khiển.
+     *
+     * @param out Nơi nhận thống kê.
+     */
+    void control_get_stats(control_stats_t *out);
+
+    /**
+     * @brief Lấy địa chỉ của người điều khiển đang giữ quyền (gửi gói hợp lệ gần nhất).
+     *
+     * @param addr Địa chỉ IPv4 (network byte order).
+     * @param port Cổng nguồn (network byte order).
+     * @return false nếu chưa nhận gói nào hoặc UDP task đã dừng.
+     */
+    bool control_get_peer(uint32_t *addr, uint16_t *port);
+
+    /**
+     * @brief Đặt car ID dùng để đọc slot trong gói đội xe; gọi trước start_udp_task().
+     *
+     * @param id 0 -> CONTROL_FLEET_MAX-1, hoặc CONTROL_CAR_ID_NONE để bỏ qua gói đội xe.
+     * @return ESP_OK hoặc ESP_ERR_INVALID_ARG.
+     */
+    esp_err_t control_set_car_id(uint8_t id);
+
+    /**
+     * @brief Car ID hiện tại (CONTROL_CAR_ID_NONE nếu chưa đặt).
+     */
+    uint8_t control_get_car_id(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // CONTROL_H
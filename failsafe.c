@@ -0,0 +1,170 @@
+#include "failsafe.h"
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <esp_log.h>
+#include "hal.h"
+#include "motor.h"
+#include "latency.h"
+#include "sysmon.h"
+
+static const char *TAG = "failsafe";
+
+/*===================== Bộ máy trạng thái =====================*/
+
+void failsafe_init(failsafe_t *fs, const failsafe_config_t *config)
+{
+    *fs = (failsafe_t){.config = *config, .state = FAILSAFE_OK};
+}
+
+failsafe_state_t failsafe_packet(failsafe_t *fs, int64_t now_us)
+{
+    failsafe_state_t prev = fs->state;
+    if (fs->armed)
+    {
+        // Khoảng mất gói không phải nhịp gửi: chặn ở hold_ms để không nới ngưỡng sau mỗi lần mất sóng
+        int64_t interval = now_us - fs->last_packet_us;
+        int64_t hold_us = (int64_t)fs->config.hold_ms * 1000;
+        if (interval > hold_us)
+            interval = hold_us;
+        if (fs->interval_avg_us == 0)
+            fs->interval_avg_us = interval;
+        else
+            fs->interval_avg_us += (interval - fs->interval_avg_us) / 8;
+    }
+    fs->armed = true;
+    fs->last_packet_us = now_us;
+    fs->state = FAILSAFE_OK;
+    return prev;
+}
+
+failsafe_action_t failsafe_update(failsafe_t *fs, int64_t now_us)
+{
+    failsafe_action_t action = {.state = fs->state};
+    if (!fs->armed)
+        return action;
+
+    // Bộ gửi thưa: dời cả ba ngưỡng theo phần vượt của interval_factor * khoảng cách trung bình
+    const failsafe_config_t *cfg = &fs->config;
+    int64_t extra_us = fs->interval_avg_us * cfg->interval_factor - (int64_t)cfg->hold_ms * 1000;
+    if (extra_us < 0)
+        extra_us = 0;
+    else if (extra_us > FAILSAFE_EXTRA_MAX_MS * 1000)
+        extra_us = FAILSAFE_EXTRA_MAX_MS * 1000;
+    int64_t hold_us = (int64_t)cfg->hold_ms * 1000 + extra_us;
+    int64_t coast_us = (int64_t)cfg->coast_ms * 1000 + extra_us;
+    int64_t brake_us = (int64_t)cfg->brake_ms * 1000 + extra_us;
+
+    int64_t silent_us = now_us - fs->last_packet_us;
+    failsafe_state_t next = silent_us >= brake_us ? FAILSAFE_BRAKE
+                          : silent_us >= coast_us ? FAILSAFE_COAST
+                          : silent_us >= hold_us  ? FAILSAFE_HOLD
+                                                  : FAILSAFE_OK;
+    // Chỉ leo thang; về FAILSAFE_OK duy nhất qua failsafe_packet()
+    if (next < fs->state)
+        next = fs->state;
+
+    if (next != fs->state)
+    {
+        fs->state = next;
+        fs->trips[next]++;
+        action.entered = true;
+    }
+    action.state = next;
+    return action;
+}
+
+/*========================= Task =========================*/
+
+static failsafe_t monitor;
+static TaskHandle_t failsafe_task_handle = NULL;
+
+void failsafe_notify_packet(void)
+{
+    failsafe_state_t prev = failsafe_packet(&monitor, hal_time_us());
+    if (prev >= FAILSAFE_COAST)
+        ESP_LOGI(TAG, "Có gói điều khiển trở lại, thoát failsafe");
+}
+
+void failsafe_configure(const failsafe_config_t *config)
+{
+    motor_lock();
+    monitor.config = *config;
+    motor_unlock();
+}
+
+failsafe_state_t failsafe_get_state(void)
+{
+    return monitor.state;
+}
+
+/*---------------------------------------------------------------
+ * Failsafe task:
+ * Chạy theo chu kỳ FAILSAFE_TICK_MS, không phụ thuộc UDP task (có thể đang
+ * chặn trong recvfrom). Mọi thao tác lên motor/servo đều giữ motor_lock().
+ *--------------------------------------------------------------*/
+static void failsafe_task(void *pvParameters)
+{
+    TickType_t wake = xTaskGetTickCount();
+#if LATENCY_TRACE
+    uint32_t last_cycles = hal_cycles();
+#endif
+
+    while (1)
+    {
+        vTaskDelayUntil(&wake, pdMS_TO_TICKS(FAILSAFE_TICK_MS));
+#if LATENCY_TRACE
+        // Độ trễ thức dậy trên core điều khiển: phần chu kỳ dài hơn FAILSAFE_TICK_MS
+        uint32_t now_cycles = hal_cycles();
+        uint32_t elapsed = now_cycles - last_cycles;
+        uint32_t period = FAILSAFE_TICK_MS * 1000u * hal_cycles_per_us();
+        latency_record(LATENCY_WAKEUP, elapsed > period ? elapsed - period : 0);
+        last_cycles = now_cycles;
+#endif
+
+        motor_lock();
+        failsafe_action_t action = failsafe_update(&monitor, hal_time_us());
+        switch (action.state)
+        {
+        case FAILSAFE_HOLD:
+            if (action.entered)
+                ESP_LOGW(TAG, "Gói điều khiển bị trễ, giữ lệnh cuối");
+            break;
+
+        case FAILSAFE_COAST:
+            if (action.entered)
+            {
+                // Fade phần cứng đưa duty về 0, task không phải làm gì thêm
+                ESP_LOGW(TAG, "Mất gói điều khiển, giảm tốc từ duty %u",
+                         (unsigned)hal_pwm_get_duty(HAL_PWM_MOTOR));
+                motor_coast(monitor.config.coast_ramp_ms);
+            }
+            break;
+
+        case FAILSAFE_BRAKE:
+            if (action.entered)
+            {
+                ESP_LOGE(TAG, "Mất gói điều khiển, phanh và trả lái về giữa");
+                motor_brake();
+                servo_set_angle(90);
+            }
+            break;
+
+        default:
+            break;
+        }
+        motor_unlock();
+    }
+}
+
+SYSMON_TASK_STORAGE(failsafe, TASK_FAILSAFE_STACK);
+
+void start_failsafe_task(void)
+{
+    if (failsafe_task_handle == NULL)
+    {
+        static const failsafe_config_t config = FAILSAFE_CONFIG_DEFAULT;
+        failsafe_init(&monitor, &config);
+        SYSMON_TASK_CREATE(failsafe, failsafe_task, "failsafe", NULL, TASK_FAILSAFE_PRIO, TASK_FAILSAFE_CORE, &failsafe_task_handle);
+        ESP_LOGI(TAG, "Failsafe task started");
+    }
+}
@@ -0,0 +1,114 @@
+#ifndef FAILSAFE_H
+#define FAILSAFE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#define FAILSAFE_TICK_MS 20 // Chu kỳ kiểm tra của failsafe task
+
+// Phần dời ngưỡng tối đa cho bộ gửi thưa: xe không chạy mù lâu hơn ngưỡng cấu hình quá chừng này
+#ifndef FAILSAFE_EXTRA_MAX_MS
+#define FAILSAFE_EXTRA_MAX_MS 100
+#endif
+
+    /**
+     * @brief Các mức failsafe khi mất gói điều khiển, tăng dần theo thời gian im lặng.
+     */
+    typedef enum
+    {
+        FAILSAFE_OK,    // Gói đến đều đặn (hoặc chưa từng nhận gói nào)
+        FAILSAFE_HOLD,  // Trễ bất thường: giữ nguyên lệnh cuối
+        FAILSAFE_COAST, // Giảm dần duty motor về 0 (motor_coast với coast_ramp_ms)
+        FAILSAFE_BRAKE, // Phanh motor và đưa servo về giữa
+    } failsafe_state_t;
+
+    /**
+     * @brief Ngưỡng failsafe (tính từ gói hợp lệ cuối cùng).
+     *
+     * Nếu interval_factor * khoảng cách trung bình giữa các gói lớn hơn hold_ms,
+     * cả ba ngưỡng được dời thêm phần chênh lệch đó (tối đa FAILSAFE_EXTRA_MAX_MS),
+     * để bộ điều khiển gửi thưa không bị báo động giả mà vẫn giữ đủ các mức.
+     * Khoảng cách từ hold_ms trở lên (lần mất gói) được tính như hold_ms khi lấy
+     * trung bình, nên một lần mất sóng không nới ngưỡng cho lần sau.
+     */
+    typedef struct
+    {
+        uint32_t hold_ms;
+        uint32_t coast_ms;
+        uint32_t brake_ms;
+        uint32_t coast_ramp_ms;   // Thời gian giảm từ duty tối đa về 0
+        uint32_t interval_factor;
+    } failsafe_config_t;
+
+#define FAILSAFE_CONFIG_DEFAULT                                                              \
+    {                                                                                        \
+        .hold_ms = 150, .coast_ms = 400, .brake_ms = 1000, .coast_ramp_ms = 300, .interval_factor = 4 \
+    }
+
+    /**
+     * @brief Bộ máy trạng thái failsafe; không gọi RTOS hay phần cứng, thời gian được
+     * truyền vào từ ngoài nên chạy được với đồng hồ giả lập.
+     */
+    typedef struct
+    {
+        failsafe_config_t config;
+        failsafe_state_t state;
+        bool armed;               // Đã nhận ít nhất một gói
+        int64_t last_packet_us;
+        int64_t interval_avg_us;  // Trung bình trượt (1/8) khoảng cách giữa các gói, mỗi mẫu <= hold_ms
+        uint32_t trips[FAILSAFE_BRAKE + 1]; // Số lần vào từng mức
+    } failsafe_t;
+
+    /**
+     * @brief Kết quả của failsafe_update().
+     */
+    typedef struct
+    {
+        failsafe_state_t state;
+        bool entered;            // Vừa chuyển sang state ở lần cập nhật này
+    } failsafe_action_t;
+
+    void failsafe_init(failsafe_t *fs, const failsafe_config_t *config);
+
+    /**
+     * @brief Báo có gói hợp lệ lúc now_us; đưa failsafe về FAILSAFE_OK.
+     *
+     * @return Trạng thái trước khi nhận gói.
+     */
+    failsafe_state_t failsafe_packet(failsafe_t *fs, int64_t now_us);
+
+    /**
+     * @brief Tính mức failsafe tại now_us.
+     */
+    failsafe_action_t failsafe_update(failsafe_t *fs, int64_t now_us);
+
+    /**
+     * @brief Tạo task failsafe (chỉ tạo một lần), độc lập với UDP task.
+     */
+    void start_failsafe_task(void);
+
+    /**
+     * @brief Gọi từ UDP task khi áp dụng một gói hợp lệ, trong lúc giữ motor_lock().
+     */
+    void failsafe_notify_packet(void);
+
+    /**
+     * @brief Đổi ngưỡng của failsafe task lúc đang chạy.
+     */
+    void failsafe_configure(const failsafe_config_t *config);
+
+    /**
+     * @brief Trạng thái hiện tại của failsafe task.
+     */
+    failsafe_state_t failsafe_get_state(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // FAILSAFE_H
@@ -0,0 +1,188 @@
+#ifndef HAL_H
+#define HAL_H
+
+/*---------------------------------------------------------------
+ * Lớp trừu tượng phần cứng (HAL) cho PWM, GPIO, I2C và đồng hồ.
+ *
+ * Hai backend:
+ *   - hal_esp32.c: LEDC, GPIO, I2C master và esp_timer của ESP-IDF.
+ *   - hal_linux.c: target linux của ESP-IDF; PWM/GPIO được mô phỏng
+ *     (lưu trạng thái kèm thời điểm ghi), I2C chuyển tới các thiết bị
+ *     giả lập gắn bằng hal_sim_i2c_attach().
+ *
+ * Task, queue và socket vẫn dùng FreeRTOS/lwIP trực tiếp: trên target
+ * linux FreeRTOS chạy trên POSIX thread và socket là socket thật của host.
+ *--------------------------------------------------------------*/
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include "esp_err.h"
+#include "sdkconfig.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+    // Các kênh PWM của xe
+    typedef enum
+    {
+        HAL_PWM_MOTOR, // Kênh PWM tốc độ motor (BTS7960)
+        HAL_PWM_SERVO, // Kênh PWM servo lái
+        HAL_PWM_COUNT,
+    } hal_pwm_channel_t;
+
+    /**
+     * @brief Cấu hình timer và kênh PWM, duty ban đầu bằng 0.
+     *
+     * @param channel Kênh PWM.
+     * @param gpio Chân xuất PWM.
+     * @param freq_hz Tần số PWM.
+     * @param resolution_bits Độ phân giải duty (bit).
+     * @return esp_err_t kết quả cấu hình.
+     */
+    esp_err_t hal_pwm_init(hal_pwm_channel_t channel, int gpio, uint32_t freq_hz, uint8_t resolution_bits);
+
+    /**
+     * @brief Đặt và áp dụng ngay duty của kênh PWM.
+     */
+    esp_err_t hal_pwm_set_duty(hal_pwm_channel_t channel, uint32_t duty);
+
+    /**
+     * @brief Đọc duty hiện tại của kênh PWM.
+     */
+    uint32_t hal_pwm_get_duty(hal_pwm_channel_t channel);
+
+    /**
+     * @brief Đổi tần số timer của kênh PWM, giữ nguyên độ phân giải.
+     *
+     * Duty tính theo chu kỳ nên người gọi phải ghi lại duty sau khi đổi tần số.
+     */
+    esp_err_t hal_pwm_set_freq(hal_pwm_channel_t channel, uint32_t freq_hz);
+
+    /**
+     * @brief Hàm được gọi khi một lần fade kết thúc; trên ESP32 chạy trong ISR của LEDC.
+     *
+     * @return true nếu đã đánh thức task có ưu tiên cao hơn (cần yield khi thoát ISR).
+     */
+    typedef bool (*hal_pwm_fade_cb_t)(hal_pwm_channel_t channel, void *arg);
+
+    /**
+     * @brief Chuyển duty tuyến tính tới giá trị mới bằng bộ fade phần cứng, không chờ.
+     *
+     * Fade đang chạy trên kênh bị dừng tại duty hiện tại rồi fade mới bắt đầu từ đó.
+     * hal_pwm_set_duty() cũng dừng fade đang chạy.
+     *
+     * @param duty Duty đích.
+     * @param time_ms Thời gian fade; 0 thì đặt duty ngay và không gọi callback.
+     */
+    esp_err_t hal_pwm_fade_to(hal_pwm_channel_t channel, uint32_t duty, uint32_t time_ms);
+
+    /**
+     * @brief Đăng ký hàm gọi khi fade trên kênh kết thúc.
+     */
+    esp_err_t hal_pwm_set_fade_callback(hal_pwm_channel_t channel, hal_pwm_fade_cb_t cb, void *arg);
+
+    /**
+     * @brief Cấu hình một chân GPIO làm output.
+     */
+    esp_err_t hal_gpio_set_output(int gpio);
+
+    /**
+     * @brief Đặt mức logic của chân GPIO output.
+     */
+    esp_err_t hal_gpio_set_level(int gpio, uint32_t level);
+
+    /**
+     * @brief Khởi tạo bus I2C master.
+     *
+     * @param sda_gpio Chân SDA.
+     * @param scl_gpio Chân SCL.
+     * @param freq_hz Tốc độ bus.
+     */
+    esp_err_t hal_i2c_init(int sda_gpio, int scl_gpio, uint32_t freq_hz);
+
+    /**
+     * @brief Ghi một giao dịch I2C (start - địa chỉ - dữ liệu - stop).
+     *
+     * @param addr Địa chỉ 7 bit của thiết bị.
+     * @param data Dữ liệu cần ghi.
+     * @param len Độ dài dữ liệu.
+     * @param timeout_ms Thời gian chờ tối đa.
+     */
+    esp_err_t hal_i2c_write(uint8_t addr, const uint8_t *data, size_t len, uint32_t timeout_ms);
+
+    /**
+     * @brief Thời gian đơn điệu kể từ khi khởi động (us).
+     */
+    int64_t hal_time_us(void);
+
+    /**
+     * @brief Bộ đếm chu kỳ CPU (32 bit, được phép wrap); dùng để đo khoảng ngắn.
+     */
+    uint32_t hal_cycles(void);
+
+    /**
+     * @brief Số chu kỳ của hal_cycles() trong một micro giây.
+     */
+    uint32_t hal_cycles_per_us(void);
+
+    /**
+     * @brief Dung lượng heap còn trống (byte); 0 nếu target không đo được.
+     */
+    uint32_t hal_free_heap(void);
+
+    /**
+     * @brief Heap trống thấp nhất từ lúc khởi động (byte); 0 nếu target không đo được.
+     */
+    uint32_t hal_min_free_heap(void);
+
+#if CONFIG_IDF_TARGET_LINUX
+    /**
+     * @brief Trạng thái mô phỏng của một kênh PWM (chỉ có trên target linux).
+     */
+    typedef struct
+    {
+        int gpio;
+        uint32_t freq_hz;
+        uint8_t resolution_bits;
+        uint32_t duty;
+        uint32_t writes;    // Số lần duty được ghi
+        int64_t updated_us; // hal_time_us() lúc ghi duty gần nhất
+    } hal_sim_pwm_t;
+
+    /**
+     * @brief Trạng thái mô phỏng của một chân GPIO (chỉ có trên target linux).
+     */
+    typedef struct
+    {
+        uint32_t level;
+        uint32_t writes;
+        int64_t updated_us;
+    } hal_sim_gpio_t;
+
+    // Thiết bị I2C giả lập: nhận nguyên một giao dịch ghi
+    typedef esp_err_t (*hal_sim_i2c_write_t)(const uint8_t *data, size_t len);
+
+    /**
+     * @brief Gắn thiết bị giả lập vào địa chỉ I2C; ghi tới địa chỉ chưa gắn trả về ESP_FAIL (NACK).
+     */
+    esp_err_t hal_sim_i2c_attach(uint8_t addr, hal_sim_i2c_write_t write);
+
+    /**
+     * @brief Chụp trạng thái mô phỏng của kênh PWM.
+     */
+    void hal_sim_get_pwm(hal_pwm_channel_t channel, hal_sim_pwm_t *out);
+
+    /**
+     * @brief Chụp trạng thái mô phỏng của chân GPIO.
+     */
+    void hal_sim_get_gpio(int gpio, hal_sim_gpio_t *out);
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // HAL_H
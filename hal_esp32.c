@@ -0,0 +1,191 @@
+#include "hal.h"
+
+#if !CONFIG_IDF_TARGET_LINUX
+#include "driver/ledc.h"
+#include "driver/gpio.h"
+#include "driver/i2c.h"
+#include "esp_timer.h"
+#include "esp_system.h"
+#include "esp_cpu.h"
+#include "esp_rom_sys.h"
+#include "esp_log.h"
+#include "esp_attr.h"
+
+static const char *TAG = "hal";
+
+#define HAL_I2C_PORT I2C_NUM_0
+
+// Ánh xạ kênh PWM của xe sang timer/kênh LEDC
+static const struct
+{
+    ledc_mode_t mode;
+    ledc_timer_t timer;
+    ledc_channel_t channel;
+} pwm_map[HAL_PWM_COUNT] = {
+    [HAL_PWM_MOTOR] = {LEDC_HIGH_SPEED_MODE, LEDC_TIMER_0, LEDC_CHANNEL_0},
+    [HAL_PWM_SERVO] = {LEDC_LOW_SPEED_MODE, LEDC_TIMER_1, LEDC_CHANNEL_1},
+};
+
+// Trạng thái fade của từng kênh; fade_active được xóa trong ISR khi fade kết thúc
+static volatile bool fade_active[HAL_PWM_COUNT];
+static hal_pwm_fade_cb_t fade_cb[HAL_PWM_COUNT];
+static void *fade_cb_arg[HAL_PWM_COUNT];
+
+/*=================== PWM ===================*/
+esp_err_t hal_pwm_init(hal_pwm_channel_t channel, int gpio, uint32_t freq_hz, uint8_t resolution_bits)
+{
+    if (channel >= HAL_PWM_COUNT)
+        return ESP_ERR_INVALID_ARG;
+
+    ledc_timer_config_t ledc_timer = {
+        .speed_mode = pwm_map[channel].mode,
+        .duty_resolution = (ledc_timer_bit_t)resolution_bits,
+        .timer_num = pwm_map[channel].timer,
+        .freq_hz = freq_hz,
+        .clk_cfg = LEDC_AUTO_CLK};
+    esp_err_t err = ledc_timer_config(&ledc_timer);
+    if (err != ESP_OK)
+    {
+        ESP_LOGE(TAG, "LEDC timer config failed");
+        return err;
+    }
+
+    ledc_channel_config_t ledc_channel = {
+        .gpio_num = gpio,
+        .speed_mode = pwm_map[channel].mode,
+        .channel = pwm_map[channel].channel,
+        .timer_sel = pwm_map[channel].timer,
+        .duty = 0,
+        .hpoint = 0};
+    err = ledc_channel_config(&ledc_channel);
+    if (err != ESP_OK)
+        return err;
+
+    // Dịch vụ fade dùng chung cho mọi kênh; lần cài thứ hai trả về ESP_ERR_INVALID_STATE
+    err = ledc_fade_func_install(0);
+    return err == ESP_ERR_INVALID_STATE ? ESP_OK : err;
+}
+
+static void hal_pwm_fade_stop(hal_pwm_channel_t channel)
+{
+    if (fade_active[channel])
+    {
+        ledc_fade_stop(pwm_map[channel].mode, pwm_map[channel].channel);
+        fade_active[channel] = false;
+    }
+}
+
+esp_err_t hal_pwm_set_duty(hal_pwm_channel_t channel, uint32_t duty)
+{
+    hal_pwm_fade_stop(channel);
+    return ledc_set_duty_and_update(pwm_map[channel].mode, pwm_map[channel].channel, duty, 0);
+}
+
+esp_err_t hal_pwm_fade_to(hal_pwm_channel_t channel, uint32_t duty, uint32_t time_ms)
+{
+    if (time_ms == 0)
+        return hal_pwm_set_duty(channel, duty);
+
+    hal_pwm_fade_stop(channel);
+    fade_active[channel] = true;
+    esp_err_t err = ledc_set_fade_time_and_start(pwm_map[channel].mode, pwm_map[channel].channel,
+                                                 duty, time_ms, LEDC_FADE_NO_WAIT);
+    if (err != ESP_OK)
+        fade_active[channel] = false;
+    return err;
+}
+
+esp_err_t hal_pwm_set_freq(hal_pwm_channel_t channel, uint32_t freq_hz)
+{
+    if (channel >= HAL_PWM_COUNT)
+        return ESP_ERR_INVALID_ARG;
+    return ledc_set_freq(pwm_map[channel].mode, pwm_map[channel].timer, freq_hz);
+}
+
+static IRAM_ATTR bool hal_pwm_fade_isr(const ledc_cb_param_t *param, void *user_arg)
+{
+    hal_pwm_channel_t channel = (hal_pwm_channel_t)(uintptr_t)user_arg;
+    if (param->event != LEDC_FADE_END_EVT)
+        return false;
+    fade_active[channel] = false;
+    return fade_cb[channel] ? fade_cb[channel](channel, fade_cb_arg[channel]) : false;
+}
+
+esp_err_t hal_pwm_set_fade_callback(hal_pwm_channel_t channel, hal_pwm_fade_cb_t cb, void *arg)
+{
+    if (channel >= HAL_PWM_COUNT)
+        return ESP_ERR_INVALID_ARG;
+    fade_cb[channel] = cb;
+    fade_cb_arg[channel] = arg;
+    ledc_cbs_t cbs = {.fade_cb = hal_pwm_fade_isr};
+    return ledc_cb_register(pwm_map[channel].mode, pwm_map[channel].channel, &cbs, (void *)(uintptr_t)channel);
+}
+
+uint32_t hal_pwm_get_duty(hal_pwm_channel_t channel)
+{
+    return ledc_get_duty(pwm_map[channel].mode, pwm_map[channel].channel);
+}
+
+/*=================== GPIO ===================*/
+esp_err_t hal_gpio_set_output(int gpio)
+{
+    return gpio_set_direction(gpio, GPIO_MODE_OUTPUT);
+}
+
+esp_err_t hal_gpio_set_level(int gpio, uint32_t level)
+{
+    return gpio_set_level(gpio, level);
+}
+
+/*=================== I2C ===================*/
+esp_err_t hal_i2c_init(int sda_gpio, int scl_gpio, uint32_t freq_hz)
+{
+    i2c_config_t conf = {
+        .mode = I2C_MODE_MASTER,
+        .sda_io_num = sda_gpio,
+        .scl_io_num = scl_gpio,
+        .sda_pullup_en = GPIO_PULLUP_ENABLE,
+        .scl_pullup_en = GPIO_PULLUP_ENABLE,
+        .master.clk_speed = freq_hz,
+    };
+    esp_err_t err = i2c_param_config(HAL_I2C_PORT, &conf);
+    if (err != ESP_OK)
+    {
+        ESP_LOGE(TAG, "I2C param config failed");
+        return err;
+    }
+    return i2c_driver_install(HAL_I2C_PORT, conf.mode, 0, 0, 0);
+}
+
+esp_err_t hal_i2c_write(uint8_t addr, const uint8_t *data, size_t len, uint32_t timeout_ms)
+{
+    return i2c_master_write_to_device(HAL_I2C_PORT, addr, data, len, pdMS_TO_TICKS(timeout_ms));
+}
+
+/*=================== Clock ===================*/
+int64_t hal_time_us(void)
+{
+    return esp_timer_get_time();
+}
+
+uint32_t hal_cycles(void)
+{
+    return (uint32_t)esp_cpu_get_cycle_count();
+}
+
+uint32_t hal_cycles_per_us(void)
+{
+    return esp_rom_get_cpu_ticks_per_us();
+}
+
+uint32_t hal_free_heap(void)
+{
+    return esp_get_free_heap_size();
+}
+
+uint32_t hal_min_free_heap(void)
+{
+    return esp_get_minimum_free_heap_size();
+}
+
+#endif // !CONFIG_IDF_TARGET_LINUX
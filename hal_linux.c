@@ -0,0 +1,258 @@
+#include "hal.h"
+
+#if CONFIG_IDF_TARGET_LINUX
+#include <pthread.h>
+#include <string.h>
+#include <time.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
+#define HAL_SIM_GPIO_COUNT 40
+#define HAL_SIM_I2C_DEVICES 4
+
+// Trạng thái phần cứng mô phỏng; được đọc từ task khác nên bảo vệ bằng mutex
+static pthread_mutex_t sim_lock = PTHREAD_MUTEX_INITIALIZER;
+static hal_sim_pwm_t sim_pwm[HAL_PWM_COUNT];
+
+// Fade mô phỏng: một task FreeRTOS nội suy duty mỗi tick và gọi callback khi xong.
+// Dùng task thay vì pthread để callback được phép gọi API FreeRTOS như trên ESP32.
+static struct
+{
+    bool active;
+    uint32_t from;
+    uint32_t to;
+    int64_t start_us;
+    int64_t end_us;
+    hal_pwm_fade_cb_t cb;
+    void *arg;
+} sim_fade[HAL_PWM_COUNT];
+static pthread_once_t sim_fade_once = PTHREAD_ONCE_INIT;
+static hal_sim_gpio_t sim_gpio[HAL_SIM_GPIO_COUNT];
+static struct
+{
+    uint8_t addr;
+    hal_sim_i2c_write_t write;
+} sim_i2c[HAL_SIM_I2C_DEVICES];
+
+/*=================== PWM ===================*/
+esp_err_t hal_pwm_init(hal_pwm_channel_t channel, int gpio, uint32_t freq_hz, uint8_t resolution_bits)
+{
+    if (channel >= HAL_PWM_COUNT || resolution_bits == 0 || resolution_bits > 20)
+        return ESP_ERR_INVALID_ARG;
+
+    pthread_mutex_lock(&sim_lock);
+    sim_pwm[channel] = (hal_sim_pwm_t){
+        .gpio = gpio,
+        .freq_hz = freq_hz,
+        .resolution_bits = resolution_bits,
+        .duty = 0,
+        .writes = 0,
+        .updated_us = hal_time_us(),
+    };
+    pthread_mutex_unlock(&sim_lock);
+    return ESP_OK;
+}
+
+esp_err_t hal_pwm_set_duty(hal_pwm_channel_t channel, uint32_t duty)
+{
+    if (channel >= HAL_PWM_COUNT || duty > (1u << sim_pwm[channel].resolution_bits))
+        return ESP_ERR_INVALID_ARG;
+
+    pthread_mutex_lock(&sim_lock);
+    sim_fade[channel].active = false;
+    sim_pwm[channel].duty = duty;
+    sim_pwm[channel].writes++;
+    sim_pwm[channel].updated_us = hal_time_us();
+    pthread_mutex_unlock(&sim_lock);
+    return ESP_OK;
+}
+
+static void sim_fade_task(void *arg)
+{
+    while (1)
+    {
+        vTaskDelay(1);
+
+        hal_pwm_fade_cb_t done_cb[HAL_PWM_COUNT] = {0};
+        void *done_arg[HAL_PWM_COUNT];
+        pthread_mutex_lock(&sim_lock);
+        int64_t now = hal_time_us();
+        for (int ch = 0; ch < HAL_PWM_COUNT; ch++)
+        {
+            if (!sim_fade[ch].active)
+                continue;
+            if (now >= sim_fade[ch].end_us)
+            {
+                sim_pwm[ch].duty = sim_fade[ch].to;
+                sim_fade[ch].active = false;
+                done_cb[ch] = sim_fade[ch].cb;
+                done_arg[ch] = sim_fade[ch].arg;
+            }
+            else
+            {
+                int64_t span = sim_fade[ch].end_us - sim_fade[ch].start_us;
+                int64_t delta = (int64_t)sim_fade[ch].to - sim_fade[ch].from;
+                sim_pwm[ch].duty = (uint32_t)(sim_fade[ch].from + delta * (now - sim_fade[ch].start_us) / span);
+            }
+            sim_pwm[ch].updated_us = now;
+        }
+        pthread_mutex_unlock(&sim_lock);
+
+        // Gọi callback ngoài khóa, thay cho ISR của LEDC
+        for (int ch = 0; ch < HAL_PWM_COUNT; ch++)
+            if (done_cb[ch])
+                done_cb[ch]((hal_pwm_channel_t)ch, done_arg[ch]);
+    }
+}
+
+static void sim_fade_start(void)
+{
+    xTaskCreate(sim_fade_task, "hal_fade", 2048, NULL, configMAX_PRIORITIES - 1, NULL);
+}
+
+esp_err_t hal_pwm_fade_to(hal_pwm_channel_t channel, uint32_t duty, uint32_t time_ms)
+{
+    if (time_ms == 0)
+        return hal_pwm_set_duty(channel, duty);
+    if (channel >= HAL_PWM_COUNT || duty > (1u << sim_pwm[channel].resolution_bits))
+        return ESP_ERR_INVALID_ARG;
+
+    pthread_once(&sim_fade_once, sim_fade_start);
+    pthread_mutex_lock(&sim_lock);
+    int64_t now = hal_time_us();
+    sim_fade[channel].active = true;
+    sim_fade[channel].from = sim_pwm[channel].duty;
+    sim_fade[channel].to = duty;
+    sim_fade[channel].start_us = now;
+    sim_fade[channel].end_us = now + (int64_t)time_ms * 1000;
+    sim_pwm[channel].writes++;
+    pthread_mutex_unlock(&sim_lock);
+    return ESP_OK;
+}
+
+esp_err_t hal_pwm_set_fade_callback(hal_pwm_channel_t channel, hal_pwm_fade_cb_t cb, void *arg)
+{
+    if (channel >= HAL_PWM_COUNT)
+        return ESP_ERR_INVALID_ARG;
+    pthread_mutex_lock(&sim_lock);
+    sim_fade[channel].cb = cb;
+    sim_fade[channel].arg = arg;
+    pthread_mutex_unlock(&sim_lock);
+    return ESP_OK;
+}
+
+esp_err_t hal_pwm_set_freq(hal_pwm_channel_t channel, uint32_t freq_hz)
+{
+    if (channel >= HAL_PWM_COUNT || freq_hz == 0)
+        return ESP_ERR_INVALID_ARG;
+
+    pthread_mutex_lock(&sim_lock);
+    sim_pwm[channel].freq_hz = freq_hz;
+    pthread_mutex_unlock(&sim_lock);
+    return ESP_OK;
+}
+
+uint32_t hal_pwm_get_duty(hal_pwm_channel_t channel)
+{
+    pthread_mutex_lock(&sim_lock);
+    uint32_t duty = sim_pwm[channel].duty;
+    pthread_mutex_unlock(&sim_lock);
+    return duty;
+}
+
+void hal_sim_get_pwm(hal_pwm_channel_t channel, hal_sim_pwm_t *out)
+{
+    pthread_mutex_lock(&sim_lock);
+    *out = sim_pwm[channel];
+    pthread_mutex_unlock(&sim_lock);
+}
+
+/*=================== GPIO ===================*/
+esp_err_t hal_gpio_set_output(int gpio)
+{
+    return (gpio >= 0 && gpio < HAL_SIM_GPIO_COUNT) ? ESP_OK : ESP_ERR_INVALID_ARG;
+}
+
+esp_err_t hal_gpio_set_level(int gpio, uint32_t level)
+{
+    if (gpio < 0 || gpio >= HAL_SIM_GPIO_COUNT)
+        return ESP_ERR_INVALID_ARG;
+
+    pthread_mutex_lock(&sim_lock);
+    sim_gpio[gpio].level = level ? 1 : 0;
+    sim_gpio[gpio].writes++;
+    sim_gpio[gpio].updated_us = hal_time_us();
+    pthread_mutex_unlock(&sim_lock);
+    return ESP_OK;
+}
+
+void hal_sim_get_gpio(int gpio, hal_sim_gpio_t *out)
+{
+    pthread_mutex_lock(&sim_lock);
+    if (gpio >= 0 && gpio < HAL_SIM_GPIO_COUNT)
+        *out = sim_gpio[gpio];
+    else
+        memset(out, 0, sizeof(*out));
+    pthread_mutex_unlock(&sim_lock);
+}
+
+/*=================== I2C ===================*/
+esp_err_t hal_i2c_init(int sda_gpio, int scl_gpio, uint32_t freq_hz)
+{
+    return ESP_OK;
+}
+
+esp_err_t hal_sim_i2c_attach(uint8_t addr, hal_sim_i2c_write_t write)
+{
+    for (int i = 0; i < HAL_SIM_I2C_DEVICES; i++)
+    {
+        if (sim_i2c[i].write == NULL || sim_i2c[i].addr == addr)
+        {
+            sim_i2c[i].addr = addr;
+            sim_i2c[i].write = write;
+            return ESP_OK;
+        }
+    }
+    return ESP_ERR_NO_MEM;
+}
+
+esp_err_t hal_i2c_write(uint8_t addr, const uint8_t *data, size_t len, uint32_t timeout_ms)
+{
+    for (int i = 0; i < HAL_SIM_I2C_DEVICES; i++)
+        if (sim_i2c[i].write != NULL && sim_i2c[i].addr == addr)
+            return sim_i2c[i].write(data, len);
+    return ESP_FAIL; // Không có thiết bị trả ACK
+}
+
+/*=================== Clock ===================*/
+int64_t hal_time_us(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+// Trên host "chu kỳ" là nano giây của CLOCK_MONOTONIC
+uint32_t hal_cycles(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint32_t)((uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec);
+}
+
+uint32_t hal_cycles_per_us(void)
+{
+    return 1000;
+}
+
+uint32_t hal_free_heap(void)
+{
+    return 0; // Heap của tiến trình host không có ý nghĩa với xe
+}
+
+uint32_t hal_min_free_heap(void)
+{
+    return 0;
+}
+
+#endif // CONFIG_IDF_TARGET_LINUX
@@ -0,0 +1,14 @@
+# Các file nguồn của xe chạy được trên target linux (phần cứng qua hal_linux.c,
+# màn OLED qua ssd1306_sim.c). Dùng chung cho host/main và host/test/main.
+set(ROBO_CAR_DIR ${CMAKE_CURRENT_LIST_DIR}/..)
+set(ROBO_CAR_HOST_SRCS
+    ${ROBO_CAR_DIR}/hal_linux.c
+    ${ROBO_CAR_DIR}/ssd1306_sim.c
+    ${ROBO_CAR_DIR}/oled.c
+    ${ROBO_CAR_DIR}/oled_widget.c
+    ${ROBO_CAR_DIR}/motor.c
+    ${ROBO_CAR_DIR}/control.c
+    ${ROBO_CAR_DIR}/telemetry.c
+    ${ROBO_CAR_DIR}/latency.c
+    ${ROBO_CAR_DIR}/failsafe.c
+    ${ROBO_CAR_DIR}/sysmon.c)
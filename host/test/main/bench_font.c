@@ -0,0 +1,43 @@
+#include <stdio.h>
+#include "unity.h"
+#include "test_support.h"
+#include "legacy_font.h"
+#include "hal.h"
+#include "oled.h"
+
+#define BENCH_FONT_ROUNDS 20000
+
+// Chuỗi chỉ gồm ký tự font cũ có, để hai đường vẽ làm cùng một việc
+static const char bench_text[] = "Speed 80 Angle 45:1.5";
+
+static void bench_report(const char *label, int64_t start_us, double *glyphs_per_s)
+{
+    uint32_t glyphs = BENCH_FONT_ROUNDS * (sizeof(bench_text) - 1);
+    int64_t elapsed = hal_time_us() - start_us;
+    *glyphs_per_s = elapsed > 0 ? glyphs * 1e6 / elapsed : 0;
+    printf("%-22s: %10.0f glyph/s (%5.1f ns/glyph)\n", label, *glyphs_per_s, test_ns_per_call(start_us, glyphs));
+}
+
+TEST_CASE("bench: glyph/s font cũ và bảng glyph", "[bench]")
+{
+    test_oled_setup();
+    double before, after;
+
+    int64_t start = hal_time_us();
+    for (uint32_t i = 0; i < BENCH_FONT_ROUNDS; i++)
+        legacy_draw_string(0, i % OLED_PAGES, bench_text);
+    bench_report("switch + từng bit (cũ)", start, &before);
+
+    start = hal_time_us();
+    for (uint32_t i = 0; i < BENCH_FONT_ROUNDS; i++)
+        oled_draw_string(0, i % OLED_PAGES, bench_text);
+    bench_report("oled_draw_string", start, &after);
+
+    start = hal_time_us();
+    for (uint32_t i = 0; i < BENCH_FONT_ROUNDS; i++)
+        oled_draw_text(0, 3 + (i % (OLED_HEIGHT - 8)), bench_text);
+    double straddle;
+    bench_report("oled_draw_text (vắt)", start, &straddle);
+
+    printf("tăng tốc: x%.1f\n", before > 0 ? after / before : 0);
+}
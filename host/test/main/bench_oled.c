@@ -0,0 +1,57 @@
+#include <stdio.h>
+#include "unity.h"
+#include "test_support.h"
+#include "hal.h"
+#include "oled.h"
+#include "ssd1306_sim.h"
+
+#define BENCH_PRINT_CALLS 20000
+#define BENCH_CIRCLE_CALLS 20000
+#define BENCH_FRAMES 500
+#define BENCH_LINE_CHARS 18 // "frame nnnnn page n"
+
+TEST_CASE("bench: oled_print", "[bench]")
+{
+    test_oled_setup();
+    int64_t start = hal_time_us();
+    for (uint32_t i = 0; i < BENCH_PRINT_CALLS; i++)
+        oled_print(0, i % OLED_PAGES, "spd %4d ang %3d", (int)(i % 200) - 100, (int)(i % 180));
+    printf("oled_print   : %8.0f ns/lần (15 ký tự)\n", test_ns_per_call(start, BENCH_PRINT_CALLS));
+}
+
+TEST_CASE("bench: draw_circle", "[bench]")
+{
+    test_oled_setup();
+    int64_t start = hal_time_us();
+    for (uint32_t i = 0; i < BENCH_CIRCLE_CALLS; i++)
+        draw_circle(64, 32, 1 + i % 31);
+    printf("draw_circle  : %8.0f ns/lần (r 1..31)\n", test_ns_per_call(start, BENCH_CIRCLE_CALLS));
+}
+
+// Mỗi khung vẽ lại vài dòng như display task (xóa ô rồi in): đo thời gian submit + gửi và lưu lượng I2C
+static void bench_display(const char *label, uint8_t pages)
+{
+    test_oled_setup();
+    int64_t start = hal_time_us();
+    for (uint32_t i = 0; i < BENCH_FRAMES; i++)
+    {
+        for (uint8_t page = 0; page < pages; page++)
+        {
+            oled_clear_cells(0, page, BENCH_LINE_CHARS);
+            oled_print(0, page, "frame %5lu page %u", (unsigned long)i, page);
+        }
+        test_oled_flush();
+    }
+    double ns = test_ns_per_call(start, BENCH_FRAMES);
+
+    ssd1306_sim_counters_t c;
+    ssd1306_sim_get_counters(&c);
+    printf("oled_display : %8.0f ns/khung, %4lu byte, %2lu giao dịch/khung (%s)\n", ns,
+           (unsigned long)(c.bytes / BENCH_FRAMES), (unsigned long)(c.transactions / BENCH_FRAMES), label);
+}
+
+TEST_CASE("bench: oled_display", "[bench]")
+{
+    bench_display("1 trang", 1);
+    bench_display("cả màn hình", OLED_PAGES);
+}
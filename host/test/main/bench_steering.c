@@ -0,0 +1,39 @@
+#include <stdio.h>
+#include "unity.h"
+#include "hal.h"
+#include "motor.h"
+
+#define BENCH_STEER_ROUNDS 20
+
+// Tổng kết quả để trình biên dịch không bỏ vòng lặp
+static volatile int bench_sink;
+
+// Thời gian theo hal_cycles(): chu kỳ CPU trên ESP32, nano giây trên target linux
+static double bench_cycles_per_call(uint32_t start, uint32_t calls)
+{
+    return (double)(uint32_t)(hal_cycles() - start) / calls;
+}
+
+TEST_CASE("bench: steering_angle và đường float", "[bench]")
+{
+    const uint32_t calls = BENCH_STEER_ROUNDS * (2 * MAX_AXIS_VALUE + 1) * (2 * MAX_AXIS_VALUE + 1);
+    int sum = 0;
+
+    uint32_t start = hal_cycles();
+    for (int r = 0; r < BENCH_STEER_ROUNDS; r++)
+        for (int y = -MAX_AXIS_VALUE; y <= MAX_AXIS_VALUE; y++)
+            for (int x = -MAX_AXIS_VALUE; x <= MAX_AXIS_VALUE; x++)
+                sum += (int)normalize_angle(calculate_angle(x, y));
+    double before = bench_cycles_per_call(start, calls);
+
+    start = hal_cycles();
+    for (int r = 0; r < BENCH_STEER_ROUNDS; r++)
+        for (int y = -MAX_AXIS_VALUE; y <= MAX_AXIS_VALUE; y++)
+            for (int x = -MAX_AXIS_VALUE; x <= MAX_AXIS_VALUE; x++)
+                sum += steering_angle(x, y);
+    double after = bench_cycles_per_call(start, calls);
+
+    bench_sink = sum;
+    printf("calculate_angle + normalize_angle: %7.1f chu kỳ/lần\n", before);
+    printf("steering_angle                   : %7.1f chu kỳ/lần (x%.1f)\n", after, after > 0 ? before / after : 0);
+}
@@ -0,0 +1,393 @@
+/*---------------------------------------------------------------
+ * Đường vẽ chữ cũ của oled.c (trước khi đổi sang bảng glyph liên tục),
+ * giữ nguyên văn để bench_font.c so sánh tốc độ và test_font.c so sánh
+ * ảnh. Vẽ vào bộ đệm riêng legacy_buffer, không đụng tới oled.c.
+ *--------------------------------------------------------------*/
+#include "legacy_font.h"
+
+uint8_t legacy_buffer[OLED_BUFFER_SIZE];
+
+/*=================== Font 5x7 ====================*/
+// Hàm trả về con trỏ đến mảng 5 byte định nghĩa một ký tự 5x7
+static const uint8_t *get_font_data(char c)
+{
+    switch (c)
+    {
+    // ----------- Ký tự ASCII cơ bản -----------
+    // Ký tự khoảng trắng
+    case ' ':
+    {
+        static const uint8_t data[5] = {0x00, 0x00, 0x00, 0x00, 0x00};
+        return data;
+    }
+    // Chữ thường
+    case 'a':
+    {
+        static const uint8_t data[5] = {0x20, 0x54, 0x54, 0x54, 0x78};
+        return data;
+    }
+    case 'b':
+    {
+        static const uint8_t data[5] = {0x7F, 0x48, 0x44, 0x44, 0x38};
+        return data;
+    }
+    case 'c':
+    {
+        static const uint8_t data[5] = {0x38, 0x44, 0x44, 0x44, 0x20};
+        return data;
+    }
+    case 'd':
+    {
+        static const uint8_t data[5] = {0x38, 0x44, 0x44, 0x48, 0x7F};
+        return data;
+    }
+    case 'e':
+    {
+        static const uint8_t data[5] = {0x38, 0x54, 0x54, 0x54, 0x18};
+        return data;
+    }
+    case 'f':
+    {
+        static const uint8_t data[5] = {0x08, 0x7E, 0x09, 0x01, 0x02};
+        return data;
+    }
+    case 'g':
+    {
+        static const uint8_t data[5] = {0x0C, 0x52, 0x52, 0x52, 0x3E};
+        return data;
+    }
+    case 'h':
+    {
+        static const uint8_t data[5] = {0x7F, 0x08, 0x04, 0x04, 0x78};
+        return data;
+    }
+    case 'i':
+    {
+        static const uint8_t data[5] = {0x00, 0x44, 0x7D, 0x40, 0x00};
+        return data;
+    }
+    case 'j':
+    {
+        static const uint8_t data[5] = {0x20, 0x40, 0x44, 0x3D, 0x00};
+        return data;
+    }
+    case 'k':
+    {
+        static const uint8_t data[5] = {0x7F, 0x10, 0x28, 0x44, 0x00};
+        return data;
+    }
+    case 'l':
+    {
+        static const uint8_t data[5] = {0x00, 0x41, 0x7F, 0x40, 0x00};
+        return data;
+    }
+    case 'm':
+    {
+        static const uint8_t data[5] = {0x7C, 0x04, 0x18, 0x04, 0x78};
+        return data;
+    }
+    case 'n':
+    {
+        static const uint8_t data[5] = {0x7C, 0x08, 0x04, 0x04, 0x78};
+        return data;
+    }
+    case 'o':
+    {
+        static const uint8_t data[5] = {0x38, 0x44, 0x44, 0x44, 0x38};
+        return data;
+    }
+    case 'p':
+    {
+        static const uint8_t data[5] = {0x7C, 0x14, 0x14, 0x14, 0x08};
+        return data;
+    }
+    case 'q':
+    {
+        static const uint8_t data[5] = {0x08, 0x14, 0x14, 0x18, 0x7C};
+        return data;
+    }
+    case 'r':
+    {
+        static const uint8_t data[5] = {0x7C, 0x08, 0x04, 0x04, 0x08};
+        return data;
+    }
+    case 's':
+    {
+        static const uint8_t data[5] = {0x48, 0x54, 0x54, 0x54, 0x20};
+        return data;
+    }
+    case 't':
+    {
+        static const uint8_t data[5] = {0x04, 0x3F, 0x44, 0x40, 0x20};
+        return data;
+    }
+    case 'u':
+    {
+        static const uint8_t data[5] = {0x3C, 0x40, 0x40, 0x20, 0x7C};
+        return data;
+    }
+    case 'v':
+    {
+        static const uint8_t data[5] = {0x1C, 0x20, 0x40, 0x20, 0x1C};
+        return data;
+    }
+    case 'w':
+    {
+        static const uint8_t data[5] = {0x3C, 0x40, 0x30, 0x40, 0x3C};
+        return data;
+    }
+    case 'x':
+    {
+        static const uint8_t data[5] = {0x44, 0x28, 0x10, 0x28, 0x44};
+        return data;
+    }
+    case 'y':
+    {
+        static const uint8_t data[5] = {0x0C, 0x50, 0x50, 0x50, 0x3C};
+        return data;
+    }
+    case 'z':
+    {
+        static const uint8_t data[5] = {0x44, 0x64, 0x54, 0x4C, 0x44};
+        return data;
+    }
+    // Chữ in hoa
+    case 'A':
+    {
+        static const uint8_t data[5] = {0x7E, 0x11, 0x11, 0x11, 0x7E};
+        return data;
+    }
+    case 'B':
+    {
+        static const uint8_t data[5] = {0x7F, 0x49, 0x49, 0x49, 0x36};
+        return data;
+    }
+    case 'C':
+    {
+        static const uint8_t data[5] = {0x3E, 0x41, 0x41, 0x41, 0x22};
+        return data;
+    }
+    case 'D':
+    {
+        static const uint8_t data[5] = {0x7F, 0x41, 0x41, 0x22, 0x1C};
+        return data;
+    }
+    case 'E':
+    {
+        static const uint8_t data[5] = {0x7F, 0x49, 0x49, 0x49, 0x41};
+        return data;
+    }
+    case 'F':
+    {
+        static const uint8_t data[5] = {0x7F, 0x09, 0x09, 0x09, 0x01};
+        return data;
+    }
+    case 'G':
+    {
+        static const uint8_t data[5] = {0x3E, 0x41, 0x49, 0x49, 0x7A};
+        return data;
+    }
+    case 'H':
+    {
+        static const uint8_t data[5] = {0x7F, 0x08, 0x08, 0x08, 0x7F};
+        return data;
+    }
+    case 'I':
+    {
+        static const uint8_t data[5] = {0x00, 0x41, 0x7F, 0x41, 0x00};
+        return data;
+    }
+    case 'J':
+    {
+        static const uint8_t data[5] = {0x20, 0x40, 0x41, 0x3F, 0x01};
+        return data;
+    }
+    case 'K':
+    {
+        static const uint8_t data[5] = {0x7F, 0x08, 0x14, 0x22, 0x41};
+        return data;
+    }
+    case 'L':
+    {
+        static const uint8_t data[5] = {0x7F, 0x40, 0x40, 0x40, 0x40};
+        return data;
+    }
+    case 'M':
+    {
+        static const uint8_t data[5] = {0x7F, 0x02, 0x0C, 0x02, 0x7F};
+        return data;
+    }
+    case 'N':
+    {
+        static const uint8_t data[5] = {0x7F, 0x04, 0x08, 0x10, 0x7F};
+        return data;
+    }
+    case 'O':
+    {
+        static const uint8_t data[5] = {0x3E, 0x41, 0x41, 0x41, 0x3E};
+        return data;
+    }
+    case 'P':
+    {
+        static const uint8_t data[5] = {0x7F, 0x09, 0x09, 0x09, 0x06};
+        return data;
+    }
+    case 'Q':
+    {
+        static const uint8_t data[5] = {0x3E, 0x41, 0x51, 0x21, 0x5E};
+        return data;
+    }
+    case 'R':
+    {
+        static const uint8_t data[5] = {0x7F, 0x09, 0x19, 0x29, 0x46};
+        return data;
+    }
+    case 'S':
+    {
+        static const uint8_t data[5] = {0x46, 0x49, 0x49, 0x49, 0x31};
+        return data;
+    }
+    case 'T':
+    {
+        static const uint8_t data[5] = {0x01, 0x01, 0x7F, 0x01, 0x01};
+        return data;
+    }
+    case 'U':
+    {
+        static const uint8_t data[5] = {0x3F, 0x40, 0x40, 0x40, 0x3F};
+        return data;
+    }
+    case 'V':
+    {
+        static const uint8_t data[5] = {0x1F, 0x20, 0x40, 0x20, 0x1F};
+        return data;
+    }
+    case 'W':
+    {
+        static const uint8_t data[5] = {0x7F, 0x20, 0x18, 0x20, 0x7F};
+        return data;
+    }
+    case 'X':
+    {
+        static const uint8_t data[5] = {0x63, 0x14, 0x08, 0x14, 0x63};
+        return data;
+    }
+    case 'Y':
+    {
+        static const uint8_t data[5] = {0x03, 0x04, 0x78, 0x04, 0x03};
+        return data;
+    }
+    case 'Z':
+    {
+        static const uint8_t data[5] = {0x61, 0x51, 0x49, 0x45, 0x43};
+        return data;
+    }
+    // Chữ số
+    case '0':
+    {
+        static const uint8_t data[5] = {0x3E, 0x51, 0x49, 0x45, 0x3E};
+        return data;
+    }
+    case '1':
+    {
+        static const uint8_t data[5] = {0x00, 0x42, 0x7F, 0x40, 0x00};
+        return data;
+    }
+    case '2':
+    {
+        static const uint8_t data[5] = {0x42, 0x61, 0x51, 0x49, 0x46};
+        return data;
+    }
+    case '3':
+    {
+        static const uint8_t data[5] = {0x21, 0x41, 0x45, 0x4B, 0x31};
+        return data;
+    }
+    case '4':
+    {
+        static const uint8_t data[5] = {0x18, 0x14, 0x12, 0x7F, 0x10};
+        return data;
+    }
+    case '5':
+    {
+        static const uint8_t data[5] = {0x27, 0x45, 0x45, 0x45, 0x39};
+        return data;
+    }
+    case '6':
+    {
+        static const uint8_t data[5] = {0x3C, 0x4A, 0x49, 0x49, 0x30};
+        return data;
+    }
+    case '7':
+    {
+        static const uint8_t data[5] = {0x01, 0x71, 0x09, 0x05, 0x03};
+        return data;
+    }
+    case '8':
+    {
+        static const uint8_t data[5] = {0x36, 0x49, 0x49, 0x49, 0x36};
+        return data;
+    }
+    case '9':
+    {
+        static const uint8_t data[5] = {0x06, 0x49, 0x49, 0x29, 0x1E};
+        return data;
+    }
+
+    // Dấu chấm câu
+    case ':':
+    {
+        static const uint8_t data[5] = {0x00, 0x36, 0x36, 0x00, 0x00};
+        return data;
+    }
+    case '.':
+    {
+        static const uint8_t data[5] = {0x00, 0x40, 0x60, 0x00, 0x00};
+        return data;
+    }
+
+    default:
+    {
+        static const uint8_t data[5] = {0x00, 0x00, 0x00, 0x00, 0x00};
+        return data;
+    }
+    }
+}
+
+/*=================== Vẽ ký tự và chuỗi ====================*/
+// Vẽ một ký tự tại vị trí (x, page). Mỗi ký tự có kích thước 5x7 pixel + 1 pixel khoảng cách.
+static void ssd1306_draw_char(uint8_t x, uint8_t page, char c)
+{
+    const uint8_t *bitmap = get_font_data(c);
+    for (int col = 0; col < 5; col++)
+    {
+        uint8_t line = bitmap[col];
+        for (int row = 0; row < 7; row++)
+        {
+            if (line & (1 << row))
+            {
+                uint16_t index = (page * OLED_WIDTH) + x + col;
+                if (index < OLED_BUFFER_SIZE)
+                    legacy_buffer[index] |= (1 << row);
+            }
+        }
+    }
+    // Thêm 1 cột trắng làm khoảng cách sau ký tự
+    for (int row = 0; row < 7; row++)
+    {
+        uint16_t index = (page * OLED_WIDTH) + x + 5;
+        if (index < OLED_BUFFER_SIZE)
+            legacy_buffer[index] &= ~(1 << row);
+    }
+}
+
+// Vẽ chuỗi ký tự bắt đầu từ vị trí (x, page)
+void legacy_draw_string(uint8_t x, uint8_t page, const char *str)
+{
+    while (*str)
+    {
+        ssd1306_draw_char(x, page, *str);
+        x += 6; // 5 pixel cho ký tự + 1 pixel khoảng cách
+        str++;
+    }
+}
@@ -0,0 +1,26 @@
+#ifndef LEGACY_FONT_H
+#define LEGACY_FONT_H
+
+#include <stdint.h>
+#include "oled.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+    /**
+     * @brief Bộ đệm mà đường vẽ chữ cũ ghi vào (cùng bố cục với bộ đệm của oled.c).
+     */
+    extern uint8_t legacy_buffer[OLED_BUFFER_SIZE];
+
+    /**
+     * @brief oled_draw_string() bản cũ: switch theo ký tự và vẽ từng bit.
+     */
+    void legacy_draw_string(uint8_t x, uint8_t page, const char *str);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // LEGACY_FONT_H
@@ -0,0 +1,198 @@
+#include <string.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include "unity.h"
+#include "test_support.h"
+#include "hal.h"
+#include "motor.h"
+#include "oled.h"
+#include "control.h"
+
+// Thời gian chờ UDP task xử lý xong gói vừa gửi qua loopback
+#define TEST_UDP_SETTLE_MS 30
+// Project test đặt CONTROL_LEASE_MS ngắn (main/CMakeLists.txt) để test hết hạn nhanh
+#define TEST_LEASE_WAIT_MS (CONTROL_LEASE_MS + 50)
+
+// Một người điều khiển: socket riêng nên có cổng nguồn riêng
+typedef struct
+{
+    int sock;
+    uint32_t seq;
+} test_sender_t;
+
+static void sender_open(test_sender_t *s)
+{
+    s->sock = socket(AF_INET, SOCK_DGRAM, IPPROTO_IP);
+    TEST_ASSERT_TRUE(s->sock >= 0);
+    s->seq = 0;
+}
+
+// Gửi gói v1 với seq cho trước (cho phép gửi lại seq cũ để giả lập gói trùng)
+static void sender_send_seq(test_sender_t *s, uint32_t seq, int16_t j1x, int16_t j1y, uint8_t flags)
+{
+    uint8_t packet[CONTROL_V1_LEN];
+    uint16_t magic = CONTROL_MAGIC;
+    uint32_t sender_ms = (uint32_t)(hal_time_us() / 1000);
+    int16_t speed = 50;
+    memcpy(packet, &magic, 2);
+    packet[2] = CONTROL_VERSION;
+    packet[3] = flags;
+    memcpy(packet + 4, &seq, 4);
+    memcpy(packet + 8, &sender_ms, 4);
+    memcpy(packet + 12, &j1x, 2);
+    memcpy(packet + 14, &j1y, 2);
+    memcpy(packet + 16, &speed, 2);
+
+    struct sockaddr_in to = {.sin_family = AF_INET, .sin_port = htons(UDP_PORT)};
+    to.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    TEST_ASSERT_EQUAL(CONTROL_V1_LEN, sendto(s->sock, packet, sizeof(packet), 0, (struct sockaddr *)&to, sizeof(to)));
+}
+
+static void sender_send(test_sender_t *s, int16_t j1x, int16_t j1y, uint8_t flags)
+{
+    sender_send_seq(s, ++s->seq, j1x, j1y, flags);
+}
+
+static void settle(void)
+{
+    vTaskDelay(pdMS_TO_TICKS(TEST_UDP_SETTLE_MS));
+}
+
+static control_stats_t stats_now(void)
+{
+    control_stats_t st;
+    control_get_stats(&st);
+    return st;
+}
+
+static void control_setup(void)
+{
+    static bool started = false;
+    if (!started)
+    {
+        test_oled_setup();
+        servo_init();
+        pwm_init();
+        start_display_task();
+        start_udp_task();
+        vTaskDelay(pdMS_TO_TICKS(100));
+        started = true;
+    }
+}
+
+// Hai người điều khiển A, B gửi vào udp_listener_task thật qua loopback. seq của A bắt
+// đầu từ 1000, của B từ 2000, nên stats.last_seq cho biết lệnh của ai được áp dụng.
+TEST_CASE("control: lease giữa nhiều người gửi (hết hạn, giành quyền, trả quyền)", "[control]")
+{
+    control_setup();
+    // Bắt đầu từ lease trống
+    vTaskDelay(pdMS_TO_TICKS(TEST_LEASE_WAIT_MS));
+
+    test_sender_t a, b;
+    sender_open(&a);
+    sender_open(&b);
+    a.seq = 1000;
+    b.seq = 2000;
+    control_stats_t base = stats_now();
+
+    // A nhận quyền; B bị loại khi lease còn hạn
+    sender_send(&a, 0, 100, 0);
+    settle();
+    sender_send(&b, 100, 100, 0);
+    settle();
+    control_stats_t st = stats_now();
+    TEST_ASSERT_EQUAL_UINT32(base.lease_changes + 1, st.lease_changes);
+    TEST_ASSERT_EQUAL_UINT32(base.lease_rejected + 1, st.lease_rejected);
+    TEST_ASSERT_EQUAL_UINT32(1001, st.last_seq);
+
+    // B giành quyền bằng CONTROL_FLAG_TAKEOVER; từ đó A bị loại
+    sender_send(&b, 100, 100, CONTROL_FLAG_TAKEOVER);
+    settle();
+    sender_send(&a, 0, 100, 0);
+    settle();
+    st = stats_now();
+    TEST_ASSERT_EQUAL_UINT32(base.lease_changes + 2, st.lease_changes);
+    TEST_ASSERT_EQUAL_UINT32(base.lease_takeovers + 1, st.lease_takeovers);
+    TEST_ASSERT_EQUAL_UINT32(base.lease_rejected + 2, st.lease_rejected);
+    TEST_ASSERT_EQUAL_UINT32(2002, st.last_seq);
+
+    // Gói trùng của B không gia hạn lease: hết hạn tính từ gói 2002, A nhận lại quyền
+    vTaskDelay(pdMS_TO_TICKS(CONTROL_LEASE_MS / 2));
+    sender_send_seq(&b, b.seq, 100, 100, 0);
+    vTaskDelay(pdMS_TO_TICKS(TEST_LEASE_WAIT_MS - CONTROL_LEASE_MS / 2));
+    sender_send(&a, 0, 100, 0);
+    settle();
+    st = stats_now();
+    TEST_ASSERT_EQUAL_UINT32(base.duplicates + 1, st.duplicates);
+    TEST_ASSERT_EQUAL_UINT32(base.lease_changes + 3, st.lease_changes);
+    TEST_ASSERT_EQUAL_UINT32(1003, st.last_seq);
+
+    // A trả quyền; gói của B ngay sau đó (có thể cùng một lần rút hàng đợi) nhận quyền
+    sender_send(&a, 0, 0, CONTROL_FLAG_RELEASE);
+    sender_send(&b, 100, 100, 0);
+    settle();
+    st = stats_now();
+    TEST_ASSERT_EQUAL_UINT32(base.lease_changes + 4, st.lease_changes);
+    TEST_ASSERT_EQUAL_UINT32(base.lease_rejected + 2, st.lease_rejected);
+    TEST_ASSERT_EQUAL_UINT32(2003, st.last_seq);
+
+    // B trả quyền rồi gói trùng của B đến trễ: bị loại theo seq nên không chiếm lại
+    // lease trống, A nhận quyền ngay không cần chờ hết hạn
+    sender_send(&b, 0, 0, CONTROL_FLAG_RELEASE);
+    settle();
+    sender_send_seq(&b, b.seq, 0, 0, 0);
+    settle();
+    sender_send(&a, 0, 100, 0);
+    settle();
+    st = stats_now();
+    TEST_ASSERT_EQUAL_UINT32(base.duplicates + 2, st.duplicates);
+    TEST_ASSERT_EQUAL_UINT32(base.lease_changes + 5, st.lease_changes);
+    TEST_ASSERT_EQUAL_UINT32(base.lease_takeovers + 1, st.lease_takeovers);
+    TEST_ASSERT_EQUAL_UINT32(base.lease_rejected + 2, st.lease_rejected);
+    TEST_ASSERT_EQUAL_UINT32(1005, st.last_seq);
+
+    // Trả quyền để lần chạy sau bắt đầu từ lease trống; chờ display task vẽ xong
+    sender_send(&a, 0, 0, CONTROL_FLAG_RELEASE);
+    vTaskDelay(pdMS_TO_TICKS(100));
+    TEST_ASSERT_EQUAL(ESP_OK, oled_wait_idle(1000));
+    close(a.sock);
+    close(b.sock);
+}
+
+// Mất Wi-Fi rồi có IP lại nhiều lần: cùng một task (stack/TCB tĩnh) đóng rồi mở lại
+// socket, lần nào cũng nhận được gói; start/stop gọi lặp không sao
+TEST_CASE("control: dừng và chạy lại UDP task nhiều lần", "[control]")
+{
+    control_setup();
+    test_sender_t a;
+    sender_open(&a);
+    a.seq = 3000;
+
+    for (int round = 0; round < 5; round++)
+    {
+        stop_udp_task();
+        stop_udp_task();
+        control_stats_t base = stats_now();
+        sender_send(&a, 0, 100, 0); // Không có socket nào nghe: gói bị bỏ
+        settle();
+        TEST_ASSERT_EQUAL_UINT32(base.packets, stats_now().packets);
+
+        start_udp_task();
+        start_udp_task();
+        settle();
+        sender_send(&a, 0, 100, 0);
+        settle();
+        control_stats_t st = stats_now();
+        TEST_ASSERT_EQUAL_UINT32(base.packets + 1, st.packets);
+        TEST_ASSERT_EQUAL_UINT32(a.seq, st.last_seq);
+    }
+
+    sender_send(&a, 0, 0, CONTROL_FLAG_RELEASE);
+    vTaskDelay(pdMS_TO_TICKS(100));
+    TEST_ASSERT_EQUAL(ESP_OK, oled_wait_idle(1000));
+    close(a.sock);
+}
@@ -0,0 +1,91 @@
+#include "unity.h"
+#include "failsafe.h"
+
+#define MS(ms) ((int64_t)(ms) * 1000)
+
+static const failsafe_config_t test_config = FAILSAFE_CONFIG_DEFAULT;
+
+// Gửi gói đều đặn từ *now_us trong duration_ms, mỗi interval_ms một gói; *now_us trỏ tới gói cuối
+static void send_packets(failsafe_t *fs, int64_t *now_us, uint32_t interval_ms, uint32_t duration_ms)
+{
+    for (uint32_t t = 0; t <= duration_ms; t += interval_ms)
+    {
+        failsafe_packet(fs, *now_us);
+        if (t + interval_ms <= duration_ms)
+            *now_us += MS(interval_ms);
+    }
+}
+
+// Chạy đồng hồ giả lập từng ms, trả về thời điểm (ms sau gói cuối) lần đầu vào state,
+// hoặc -1 nếu không vào trong limit_ms hoặc nhảy qua state
+static int32_t first_tick_in(failsafe_t *fs, int64_t last_packet_us, failsafe_state_t state, uint32_t limit_ms)
+{
+    for (uint32_t t = 0; t <= limit_ms; t++)
+    {
+        failsafe_action_t a = failsafe_update(fs, last_packet_us + MS(t));
+        if (a.state == state && a.entered)
+            return (int32_t)t;
+        if (a.state > state)
+            return -1;
+    }
+    return -1;
+}
+
+TEST_CASE("failsafe: OK -> HOLD -> COAST -> BRAKE theo ngưỡng mặc định", "[failsafe]")
+{
+    failsafe_t fs;
+    failsafe_init(&fs, &test_config);
+    int64_t now = MS(1000);
+
+    TEST_ASSERT_EQUAL(FAILSAFE_OK, failsafe_update(&fs, now + MS(5000)).state); // chưa có gói: không báo
+    send_packets(&fs, &now, 20, 1000);
+    TEST_ASSERT_EQUAL(FAILSAFE_OK, failsafe_update(&fs, now + MS(140)).state);
+    TEST_ASSERT_EQUAL(test_config.hold_ms, first_tick_in(&fs, now, FAILSAFE_HOLD, 2000));
+    TEST_ASSERT_EQUAL(test_config.coast_ms, first_tick_in(&fs, now, FAILSAFE_COAST, 2000));
+    TEST_ASSERT_EQUAL(test_config.brake_ms, first_tick_in(&fs, now, FAILSAFE_BRAKE, 2000));
+
+    // Không leo thang lại, chỉ gói mới đưa về OK
+    failsafe_action_t a = failsafe_update(&fs, now + MS(5000));
+    TEST_ASSERT_EQUAL(FAILSAFE_BRAKE, a.state);
+    TEST_ASSERT_FALSE(a.entered);
+    TEST_ASSERT_EQUAL(FAILSAFE_BRAKE, failsafe_packet(&fs, now + MS(5000)));
+    TEST_ASSERT_EQUAL(FAILSAFE_OK, failsafe_update(&fs, now + MS(5010)).state);
+    TEST_ASSERT_EQUAL_UINT32(1, fs.trips[FAILSAFE_HOLD]);
+    TEST_ASSERT_EQUAL_UINT32(1, fs.trips[FAILSAFE_COAST]);
+    TEST_ASSERT_EQUAL_UINT32(1, fs.trips[FAILSAFE_BRAKE]);
+}
+
+TEST_CASE("failsafe: lần mất sóng dài không nới ngưỡng lần sau", "[failsafe]")
+{
+    failsafe_t fs;
+    failsafe_init(&fs, &test_config);
+    int64_t now = 0;
+
+    send_packets(&fs, &now, 20, 1000);
+    now += MS(5000); // mất sóng 5 s rồi có lại
+    send_packets(&fs, &now, 20, 200);
+
+    TEST_ASSERT_EQUAL(test_config.hold_ms, first_tick_in(&fs, now, FAILSAFE_HOLD, 2000));
+    TEST_ASSERT_EQUAL(test_config.coast_ms, first_tick_in(&fs, now, FAILSAFE_COAST, 2000));
+    TEST_ASSERT_EQUAL(test_config.brake_ms, first_tick_in(&fs, now, FAILSAFE_BRAKE, 2000));
+}
+
+TEST_CASE("failsafe: bộ gửi thưa được dời ngưỡng, có giới hạn", "[failsafe]")
+{
+    failsafe_t fs;
+    failsafe_init(&fs, &test_config);
+    int64_t now = 0;
+
+    // 60 ms * 4 = 240 ms: dời 90 ms, và gói đến đúng nhịp không bao giờ gây HOLD
+    send_packets(&fs, &now, 60, 3000);
+    TEST_ASSERT_EQUAL(FAILSAFE_OK, failsafe_update(&fs, now + MS(60)).state);
+    TEST_ASSERT_EQUAL(test_config.hold_ms + 90, first_tick_in(&fs, now, FAILSAFE_HOLD, 2000));
+    TEST_ASSERT_EQUAL(test_config.brake_ms + 90, first_tick_in(&fs, now, FAILSAFE_BRAKE, 2000));
+
+    // 100 ms * 4 = 400 ms: phần dời bị chặn ở FAILSAFE_EXTRA_MAX_MS
+    failsafe_init(&fs, &test_config);
+    send_packets(&fs, &now, 100, 5000);
+    TEST_ASSERT_EQUAL(test_config.hold_ms + FAILSAFE_EXTRA_MAX_MS, first_tick_in(&fs, now, FAILSAFE_HOLD, 2000));
+    TEST_ASSERT_EQUAL(test_config.coast_ms + FAILSAFE_EXTRA_MAX_MS, first_tick_in(&fs, now, FAILSAFE_COAST, 2000));
+    TEST_ASSERT_EQUAL(test_config.brake_ms + FAILSAFE_EXTRA_MAX_MS, first_tick_in(&fs, now, FAILSAFE_BRAKE, 2000));
+}
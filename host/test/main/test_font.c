@@ -0,0 +1,39 @@
+#include <string.h>
+#include "unity.h"
+#include "test_support.h"
+#include "legacy_font.h"
+#include "oled.h"
+#include "ssd1306_sim.h"
+
+// Mọi ký tự mà switch của font cũ có; mỗi dòng tối đa 21 ký tự vì font cũ không
+// cắt ở mép phải (phần thừa tràn sang trang dưới)
+static const char *const legacy_lines[] = {
+    "abcdefghijklmnopqrstu",
+    "vwxyz ABCDEFGHIJKLMNO",
+    "PQRSTUVWXYZ 012345678",
+    "9:. 12:34.5 Robo car",
+};
+
+TEST_CASE("font: bảng glyph vẽ giống hệt font cũ", "[oled][font]")
+{
+    test_oled_setup();
+    memset(legacy_buffer, 0, sizeof(legacy_buffer));
+    for (uint8_t i = 0; i < sizeof(legacy_lines) / sizeof(legacy_lines[0]); i++)
+    {
+        oled_draw_string(0, 2 * i, legacy_lines[i]);
+        legacy_draw_string(0, 2 * i, legacy_lines[i]);
+    }
+    test_oled_flush();
+
+    for (uint8_t y = 0; y < OLED_HEIGHT; y++)
+        for (uint8_t x = 0; x < OLED_WIDTH; x++)
+        {
+            bool want = (legacy_buffer[(y / 8) * OLED_WIDTH + x] >> (y % 8)) & 1;
+            if (ssd1306_sim_get_pixel(x, y) != want)
+            {
+                char msg[48];
+                snprintf(msg, sizeof(msg), "lệch tại (%u, %u)", x, y);
+                TEST_FAIL_MESSAGE(msg);
+            }
+        }
+}
@@ -0,0 +1,56 @@
+#include <string.h>
+#include "unity.h"
+#include "hal.h"
+#include "latency.h"
+
+TEST_CASE("latency: gộp ring vào histogram, đếm mẫu bị ghi đè", "[latency]")
+{
+    latency_reset();
+
+    // 10 mẫu 1 ms: max đúng giá trị thật, p50/p99 không vượt max
+    for (int i = 0; i < 10; i++)
+        latency_record(LATENCY_STEER, 1000 * hal_cycles_per_us());
+    latency_summary_t sum;
+    latency_get(LATENCY_STEER, &sum);
+    TEST_ASSERT_EQUAL_UINT32(10, sum.count);
+    TEST_ASSERT_EQUAL_UINT32(1000000, sum.max_ns);
+    TEST_ASSERT_EQUAL_UINT32(1000000, sum.p50_ns);
+    TEST_ASSERT_EQUAL_UINT32(1000000, sum.p99_ns);
+
+    // Ghi nhiều hơn ring mà không gộp: chỉ LATENCY_RING_SIZE mẫu mới nhất còn lại
+    for (int i = 0; i < LATENCY_RING_SIZE + 44; i++)
+        latency_record(LATENCY_PARSE, (uint32_t)(i + 1) * hal_cycles_per_us());
+    latency_get(LATENCY_PARSE, &sum);
+    TEST_ASSERT_EQUAL_UINT32(LATENCY_RING_SIZE, sum.count);
+    TEST_ASSERT_EQUAL_UINT32((LATENCY_RING_SIZE + 44) * 1000, sum.max_ns);
+
+    char report[LATENCY_STAGE_COUNT * 64 + 32];
+    size_t n = latency_format(report, sizeof(report));
+    TEST_ASSERT_EQUAL(strlen(report), n);
+    TEST_ASSERT_NOT_NULL(strstr(report, "steer   n=10 "));
+    TEST_ASSERT_NOT_NULL(strstr(report, "overruns=44\n"));
+
+    latency_reset();
+    latency_get(LATENCY_PARSE, &sum);
+    TEST_ASSERT_EQUAL_UINT32(0, sum.count);
+}
+
+TEST_CASE("latency: chặng đo bằng micro giây cùng đơn vị ns, bão hòa và không âm", "[latency]")
+{
+    latency_reset();
+
+    latency_record_us(LATENCY_DISPLAY, 2500);
+    latency_record_us(LATENCY_DISPLAY, -5); // hal_time_us() không lùi, nhưng không được tràn
+    latency_summary_t sum;
+    latency_get(LATENCY_DISPLAY, &sum);
+    TEST_ASSERT_EQUAL_UINT32(2, sum.count);
+    TEST_ASSERT_EQUAL_UINT32(2500000, sum.max_ns);
+
+    // Vượt trường 29 bit chu kỳ: bão hòa thay vì quấn về giá trị nhỏ
+    latency_record_us(LATENCY_DISPLAY, INT64_C(1) << 40);
+    latency_get(LATENCY_DISPLAY, &sum);
+    TEST_ASSERT_EQUAL_UINT32(3, sum.count);
+    TEST_ASSERT_GREATER_THAN(2500000, sum.max_ns);
+
+    latency_reset();
+}
@@ -0,0 +1,17 @@
+/*---------------------------------------------------------------
+ * Điểm vào của bộ test host (target linux): chạy các TEST_CASE Unity rồi
+ * thoát với mã lỗi khác 0 nếu có test hỏng, để dùng được trong CI.
+ * Benchmark (tag [bench]) chỉ chạy khi đặt ROBO_BENCH=1.
+ *--------------------------------------------------------------*/
+#include <stdlib.h>
+#include "unity.h"
+
+void app_main(void)
+{
+    UNITY_BEGIN();
+    if (getenv("ROBO_BENCH") != NULL)
+        unity_run_tests_by_tag("[bench]", false);
+    else
+        unity_run_tests_by_tag("[bench]", true);
+    exit(UNITY_END() == 0 ? EXIT_SUCCESS : EXIT_FAILURE);
+}
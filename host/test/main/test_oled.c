@@ -0,0 +1,69 @@
+#include "unity.h"
+#include "test_support.h"
+#include "oled.h"
+#include "ssd1306_sim.h"
+
+TEST_CASE("oled: chữ theo trang, vắt trang và ký tự có dấu", "[oled]")
+{
+    test_oled_setup();
+    oled_draw_string(0, 0, "Robo car 0123456789");
+    oled_draw_string(0, 1, "!\"#$%&'()*+,-./:;<=>?@");
+    oled_draw_string(0, 2, "ABCDEFGHIJKLMNOPQRSTU");
+    oled_draw_string(0, 3, "abcdefghijklmnopqrstu");
+    oled_draw_text(3, 37, "goc 45° tốc độ 80%");
+    oled_print(0, 6, "%-5s|%4d|%5.1f", "spd", -12, 3.5);
+    oled_draw_text(122, 57, "xy"); // chạm mép phải và mép dưới
+    test_oled_flush();
+    TEST_ASSERT_TRUE(test_golden_match("text"));
+}
+
+TEST_CASE("oled: đường tròn của con mắt", "[oled]")
+{
+    test_oled_setup();
+    draw_circle(64, 32, 20);
+    draw_circle(64, 32, 5);
+    draw_circle(4, 4, 10); // bị cắt ở góc trên trái
+    test_oled_flush();
+    TEST_ASSERT_TRUE(test_golden_match("circles"));
+}
+
+TEST_CASE("oled: cập nhật một phần chỉ gửi đoạn thay đổi", "[oled]")
+{
+    test_oled_setup();
+    oled_draw_string(0, 0, "speed");
+    oled_draw_string(0, 4, "angle");
+    oled_print(64, 0, "%4d", 10);
+    oled_print(64, 4, "%4d", 90);
+    test_oled_flush();
+
+    ssd1306_sim_counters_t full;
+    ssd1306_sim_get_counters(&full);
+    ssd1306_sim_reset_counters();
+
+    oled_clear_cells(64, 4, 4);
+    oled_print(64, 4, "%4d", 135);
+    test_oled_flush();
+
+    ssd1306_sim_counters_t partial;
+    ssd1306_sim_get_counters(&partial);
+    TEST_ASSERT_GREATER_THAN(0, partial.data_bytes);
+    TEST_ASSERT_LESS_OR_EQUAL(4 * OLED_CHAR_WIDTH, partial.data_bytes);
+    TEST_ASSERT_LESS_THAN(full.bytes, partial.bytes);
+    TEST_ASSERT_TRUE(test_golden_match("partial"));
+}
+
+TEST_CASE("oled: khung không đổi không sinh giao dịch I2C", "[oled]")
+{
+    test_oled_setup();
+    oled_draw_string(0, 2, "idle");
+    test_oled_flush();
+    ssd1306_sim_reset_counters();
+
+    test_oled_flush();
+    oled_clear_cells(OLED_WIDTH - OLED_CHAR_WIDTH, 7, 1); // xóa ô vốn đã trống
+    test_oled_flush();
+
+    ssd1306_sim_counters_t c;
+    ssd1306_sim_get_counters(&c);
+    TEST_ASSERT_EQUAL_UINT32(0, c.transactions);
+}
@@ -0,0 +1,101 @@
+#include <stdio.h>
+#include <stdint.h>
+#include "unity.h"
+#include "hal.h"
+#include "motor.h"
+
+// Đường float cũ của control.c: angle float rồi servo_set_angle(90 + angle) (ép về uint32_t)
+static int float_angle(int j1x, int j1y)
+{
+    return (int)normalize_angle(calculate_angle(j1x, j1y));
+}
+
+static uint32_t servo_duty_for(uint32_t angle)
+{
+    hal_sim_pwm_t pwm;
+    servo_set_angle(angle);
+    hal_sim_get_pwm(HAL_PWM_SERVO, &pwm);
+    return pwm.duty;
+}
+
+static void steering_setup(void)
+{
+    static bool ready = false;
+    if (!ready)
+    {
+        servo_init();
+        ready = true;
+    }
+    servo_set_hysteresis_us(0); // Mỗi góc phải ra đúng duty của nó, không bị giữ lại
+}
+
+TEST_CASE("steering: khớp đường float trên toàn [-100, 100]^2", "[steering]")
+{
+    steering_setup();
+    uint32_t mismatches = 0;
+    for (int y = -MAX_AXIS_VALUE; y <= MAX_AXIS_VALUE; y++)
+        for (int x = -MAX_AXIS_VALUE; x <= MAX_AXIS_VALUE; x++)
+        {
+            float ref = normalize_angle(calculate_angle(x, y));
+            int got = steering_angle(x, y);
+            uint32_t want_duty = servo_duty_for((uint32_t)(90 + ref));
+            uint32_t got_duty = servo_duty_for(90 + got);
+            if (got != (int)ref || got_duty != want_duty)
+            {
+                if (mismatches++ < 10)
+                    printf("(%d, %d): góc %d / %d, duty %lu / %lu\n", x, y, got, (int)ref,
+                           (unsigned long)got_duty, (unsigned long)want_duty);
+            }
+        }
+    TEST_ASSERT_EQUAL_UINT32(0, mismatches);
+}
+
+TEST_CASE("steering: hysteresis mặc định không nuốt thay đổi một độ", "[steering]")
+{
+    steering_setup();
+    servo_set_hysteresis_us(SERVO_HYSTERESIS_US);
+    hal_sim_pwm_t pwm;
+
+    // Mọi bước một độ trong hành trình lái, cả hai chiều, đều phải tới PWM
+    uint32_t prev = servo_duty_for(90 - MAX_ANGLE_REAL);
+    for (uint32_t a = 90 - MAX_ANGLE_REAL + 1; a <= 90 + MAX_ANGLE_REAL; a++)
+    {
+        uint32_t duty = servo_duty_for(a);
+        TEST_ASSERT_GREATER_THAN(prev, duty);
+        prev = duty;
+    }
+    for (uint32_t a = 90 + MAX_ANGLE_REAL - 1; a >= 90 - MAX_ANGLE_REAL; a--)
+    {
+        uint32_t duty = servo_duty_for(a);
+        TEST_ASSERT_LESS_THAN(prev, duty);
+        prev = duty;
+    }
+
+    // Rung dưới một bước góc vẫn bị lọc
+    servo_set_angle(90);
+    hal_sim_get_pwm(HAL_PWM_SERVO, &pwm);
+    prev = pwm.duty;
+    servo_set_pulse_us(SERVO_PULSE_CENTER_US + SERVO_HYSTERESIS_US - 1);
+    hal_sim_get_pwm(HAL_PWM_SERVO, &pwm);
+    TEST_ASSERT_EQUAL_UINT32(prev, pwm.duty);
+
+    servo_set_hysteresis_us(0);
+}
+
+TEST_CASE("steering: lệch tối đa một độ trên lưới int16", "[steering]")
+{
+    // Ngoài dải joystick (gói hỏng, app khác) chỉ cần sai khác không quá một bước góc
+    const int stride = 97;
+    for (int32_t y = INT16_MIN; y <= INT16_MAX; y += stride)
+        for (int32_t x = INT16_MIN; x <= INT16_MAX; x += stride)
+            TEST_ASSERT_INT_WITHIN(1, float_angle(x, y), steering_angle(x, y));
+}
+
+TEST_CASE("steering: vùng chết và giới hạn góc", "[steering]")
+{
+    TEST_ASSERT_EQUAL_INT(0, steering_angle(0, 0));
+    TEST_ASSERT_EQUAL_INT(0, steering_angle(7, 100));    // ~4 độ, nằm trong vùng chết 20 độ
+    TEST_ASSERT_EQUAL_INT(-25, steering_angle(100, 100)); // 45 độ trừ vùng chết
+    TEST_ASSERT_EQUAL_INT(25, steering_angle(-100, 100));
+    TEST_ASSERT_EQUAL_INT(-MAX_ANGLE_REAL, steering_angle(0, -100));
+}
@@ -0,0 +1,75 @@
+#include "test_support.h"
+#include "unity.h"
+#include "hal.h"
+#include "oled.h"
+#include "ssd1306_sim.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define TEST_OLED_TIMEOUT_MS 1000
+#define TEST_PATH_MAX 256
+#define TEST_PBM_SIZE (OLED_BUFFER_SIZE + 16) // Dữ liệu ảnh và header "P4\n128 64\n"
+
+void test_oled_setup(void)
+{
+    static bool ready = false;
+    if (!ready)
+    {
+        ssd1306_sim_reset();
+        TEST_ASSERT_EQUAL(ESP_OK, hal_sim_i2c_attach(OLED_ADDR, ssd1306_sim_write));
+        TEST_ASSERT_EQUAL(ESP_OK, oled_init());
+        ready = true;
+    }
+    oled_clear();
+    test_oled_flush();
+    ssd1306_sim_reset_counters();
+}
+
+void test_oled_flush(void)
+{
+    TEST_ASSERT_EQUAL(ESP_OK, oled_display());
+    TEST_ASSERT_EQUAL(ESP_OK, oled_wait_idle(TEST_OLED_TIMEOUT_MS));
+}
+
+static size_t read_file(const char *path, uint8_t *buf, size_t cap)
+{
+    FILE *f = fopen(path, "rb");
+    if (f == NULL)
+        return 0;
+    size_t n = fread(buf, 1, cap, f);
+    fclose(f);
+    return n;
+}
+
+bool test_golden_match(const char *name)
+{
+    char golden[TEST_PATH_MAX], actual[TEST_PATH_MAX];
+    snprintf(golden, sizeof(golden), "%s/%s.pbm", GOLDEN_DIR, name);
+    snprintf(actual, sizeof(actual), "%s.pbm", name);
+
+    const char *update = getenv("GOLDEN_UPDATE");
+    if (update != NULL && strcmp(update, "1") == 0)
+    {
+        printf("golden: ghi lại %s\n", golden);
+        return ssd1306_sim_write_pbm(golden) == ESP_OK;
+    }
+
+    if (ssd1306_sim_write_pbm(actual) != ESP_OK)
+        return false;
+    static uint8_t want[TEST_PBM_SIZE], got[TEST_PBM_SIZE];
+    size_t want_len = read_file(golden, want, sizeof(want));
+    size_t got_len = read_file(actual, got, sizeof(got));
+    if (want_len == 0 || want_len != got_len || memcmp(want, got, want_len) != 0)
+    {
+        printf("golden: %s lệch ảnh mẫu %s (ảnh thực tế giữ ở %s)\n", name, golden, actual);
+        return false;
+    }
+    remove(actual);
+    return true;
+}
+
+double test_ns_per_call(int64_t start_us, uint32_t calls)
+{
+    return (double)(hal_time_us() - start_us) * 1000.0 / calls;
+}
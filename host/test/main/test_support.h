@@ -0,0 +1,46 @@
+#ifndef TEST_SUPPORT_H
+#define TEST_SUPPORT_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+    /**
+     * @brief Đưa màn OLED mô phỏng về khung trống và xóa bộ đếm I2C.
+     *
+     * Lần gọi đầu gắn ssd1306_sim vào địa chỉ OLED_ADDR và gọi oled_init();
+     * các lần sau chỉ xóa bộ đệm và đẩy khung trống lên màn hình.
+     */
+    void test_oled_setup(void);
+
+    /**
+     * @brief Submit khung hiện tại và chờ worker I2C gửi xong.
+     */
+    void test_oled_flush(void);
+
+    /**
+     * @brief So sánh ảnh đang hiển thị trên màn mô phỏng với ảnh mẫu GOLDEN_DIR/<name>.pbm.
+     *
+     * Khi lệch, ảnh thực tế được giữ lại ở <name>.pbm trong thư mục hiện tại để
+     * xem bằng trình xem ảnh. Đặt biến môi trường GOLDEN_UPDATE=1 để ghi đè
+     * ảnh mẫu bằng ảnh hiện tại.
+     *
+     * @return true nếu khớp (hoặc vừa ghi lại ảnh mẫu).
+     */
+    bool test_golden_match(const char *name);
+
+    /**
+     * @brief Thời gian trung bình (ns) của một lần gọi, từ hal_time_us().
+     */
+    double test_ns_per_call(int64_t start_us, uint32_t calls);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // TEST_SUPPORT_H
@@ -0,0 +1,95 @@
+/*---------------------------------------------------------------
+ * Điểm vào cho target linux của ESP-IDF (idf.py --preview set-target linux),
+ * dùng thay cho app_main.c: không có Wi-Fi/provisioning, chạy nguyên
+ * display task và udp_listener_task của control.c trên socket UDP thật của
+ * host (cổng UDP_PORT). PWM/GPIO do hal_linux.c mô phỏng, màn OLED do
+ * ssd1306_sim.c giải mã.
+ *
+ * Build và chạy (project ở thư mục host/):
+ *   cd host && idf.py --preview set-target linux && idf.py build
+ *   ./build/robo_car_host.elf
+ *
+ * Gửi gói điều khiển thử:
+ *   printf '\x0a\x00\x32\x00\x00\x00' | nc -u -w0 127.0.0.1 65000
+ * Mỗi lệnh nc dùng một cổng nguồn mới nên là một người điều khiển khác: lệnh thứ
+ * hai trong vòng CONTROL_LEASE_MS sau lệnh đầu bị loại (lease rej trong báo cáo).
+ *
+ * Đội xe: chạy nhiều tiến trình với biến môi trường CAR_ID=0, CAR_ID=1...; mỗi
+ * tiến trình đọc slot của mình trong gói gửi tới nhóm CONTROL_FLEET_GROUP.
+ *--------------------------------------------------------------*/
+#include "sdkconfig.h"
+
+#if CONFIG_IDF_TARGET_LINUX
+#include <stdlib.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <esp_log.h>
+#include "hal.h"
+#include "motor.h"
+#include "oled.h"
+#include "control.h"
+#include "telemetry.h"
+#include "failsafe.h"
+#include "sysmon.h"
+#include "latency.h"
+#include "ssd1306_sim.h"
+
+static const char *TAG = "host";
+
+#define HOST_REPORT_MS 1000
+#define HOST_OLED_PBM "oled.pbm" // Ảnh màn hình mô phỏng, ghi lại mỗi chu kỳ báo cáo
+#define HOST_LATENCY_DUMP_EVERY 10 // In histogram độ trễ sau mỗi chừng này chu kỳ báo cáo
+
+void app_main(void)
+{
+    ssd1306_sim_reset();
+    hal_sim_i2c_attach(OLED_ADDR, ssd1306_sim_write);
+
+    if (oled_init() != ESP_OK)
+    {
+        ESP_LOGE(TAG, "OLED init failed");
+        return;
+    }
+    servo_init();
+    pwm_init();
+    start_failsafe_task();
+
+    const char *car_id = getenv("CAR_ID");
+    if (car_id != NULL && control_set_car_id((uint8_t)atoi(car_id)) != ESP_OK)
+        ESP_LOGW(TAG, "CAR_ID phải nhỏ hơn %d", CONTROL_FLEET_MAX);
+
+    start_display_task();
+    start_udp_task();
+    start_telemetry_task();
+    start_sysmon_task();
+
+    for (uint32_t report = 1;; report++)
+    {
+        vTaskDelay(pdMS_TO_TICKS(HOST_REPORT_MS));
+
+        control_stats_t stats;
+        hal_sim_pwm_t motor, servo;
+        hal_sim_gpio_t rpwm, lpwm;
+        control_get_stats(&stats);
+        hal_sim_get_pwm(HAL_PWM_MOTOR, &motor);
+        hal_sim_get_pwm(HAL_PWM_SERVO, &servo);
+        hal_sim_get_gpio(RPWM_GPIO, &rpwm);
+        hal_sim_get_gpio(LPWM_GPIO, &lpwm);
+        actuator_stats_t act;
+        actuator_get_stats(&act);
+
+        ESP_LOGI(TAG, "packets=%u stale=%u dup=%u reord=%u inv=%u jitter=%u us latency last=%lld us max=%lld us | lease rej=%u chg=%u take=%u | fleet ign=%u | motor duty=%u R=%u L=%u | servo duty=%u | writes motor=%u/%u gpio=%u/%u servo=%u/%u (issued/suppressed)",
+                 (unsigned)stats.packets, (unsigned)stats.stale_dropped, (unsigned)stats.duplicates, (unsigned)stats.reordered, (unsigned)stats.invalid, (unsigned)stats.jitter_us, (long long)stats.last_latency_us, (long long)stats.max_latency_us,
+                 (unsigned)stats.lease_rejected, (unsigned)stats.lease_changes, (unsigned)stats.lease_takeovers,
+                 (unsigned)stats.fleet_ignored,
+                 (unsigned)motor.duty, (unsigned)rpwm.level, (unsigned)lpwm.level, (unsigned)servo.duty,
+                 (unsigned)act.motor_pwm.issued, (unsigned)act.motor_pwm.suppressed, (unsigned)act.bridge_gpio.issued, (unsigned)act.bridge_gpio.suppressed,
+                 (unsigned)act.servo_pwm.issued, (unsigned)act.servo_pwm.suppressed);
+        ssd1306_sim_write_pbm(HOST_OLED_PBM);
+#if LATENCY_TRACE
+        if (report % HOST_LATENCY_DUMP_EVERY == 0)
+            latency_dump();
+#endif
+    }
+}
+#endif // CONFIG_IDF_TARGET_LINUX
@@ -0,0 +1,233 @@
+#include "latency.h"
+
+#if LATENCY_TRACE
+#include <stdio.h>
+#include <string.h>
+#include <freertos/FreeRTOS.h>
+#include <esp_log.h>
+
+static const char *TAG = "latency";
+
+/*
+ * Mỗi mẫu là một từ 32 bit: 3 bit cao là (stage + 1), 29 bit thấp là số chu kỳ
+ * (bão hòa ở ~2.2 s với 240 MHz). Giá trị 0 nghĩa là ô chưa được ghi, nên phía
+ * gộp dừng lại ở ô đó và đọc tiếp ở lần sau.
+ */
+#define SAMPLE_STAGE_SHIFT 29
+#define SAMPLE_CYCLES_MASK ((1u << SAMPLE_STAGE_SHIFT) - 1)
+
+static uint32_t ring[LATENCY_RING_SIZE];
+static uint32_t ring_head; // Vị trí ghi kế tiếp, tăng bằng atomic fetch_add
+static uint32_t ring_tail; // Vị trí đọc kế tiếp, chỉ phía gộp dùng (dưới hist_lock)
+static uint32_t ring_overruns;
+
+typedef struct
+{
+    uint32_t count;
+    uint32_t max_ns;
+    uint32_t buckets[LATENCY_BUCKETS];
+} stage_hist_t;
+
+static stage_hist_t hist[LATENCY_STAGE_COUNT];
+
+// Chỉ phía gộp/đọc giữ khóa; latency_record() không bao giờ chờ
+static portMUX_TYPE hist_lock = portMUX_INITIALIZER_UNLOCKED;
+
+static const char *const stage_names[LATENCY_STAGE_COUNT] = {
+    [LATENCY_PARSE] = "parse",
+    [LATENCY_STEER] = "steer",
+    [LATENCY_ACTUATE] = "actuate",
+    [LATENCY_TOTAL] = "total",
+    [LATENCY_DISPLAY] = "display",
+    [LATENCY_WAKEUP] = "wakeup",
+};
+
+void latency_record(latency_stage_t stage, uint32_t cycles)
+{
+    if (cycles > SAMPLE_CYCLES_MASK)
+        cycles = SAMPLE_CYCLES_MASK;
+    uint32_t idx = __atomic_fetch_add(&ring_head, 1, __ATOMIC_RELAXED);
+    __atomic_store_n(&ring[idx & (LATENCY_RING_SIZE - 1)],
+                     ((uint32_t)(stage + 1) << SAMPLE_STAGE_SHIFT) | cycles, __ATOMIC_RELEASE);
+}
+
+void latency_record_us(latency_stage_t stage, int64_t us)
+{
+    if (us < 0)
+        us = 0;
+    uint64_t cycles = (uint64_t)us * hal_cycles_per_us();
+    latency_record(stage, cycles > SAMPLE_CYCLES_MASK ? SAMPLE_CYCLES_MASK : (uint32_t)cycles);
+}
+
+// Bucket log2 với LATENCY_SUB_BITS bit con tuyến tính
+static uint32_t bucket_of(uint32_t ns)
+{
+    if (ns < (1u << LATENCY_SUB_BITS))
+        return ns;
+    uint32_t msb = 31 - __builtin_clz(ns);
+    uint32_t b = ((msb - LATENCY_SUB_BITS + 1) << LATENCY_SUB_BITS) |
+                 ((ns >> (msb - LATENCY_SUB_BITS)) & ((1u << LATENCY_SUB_BITS) - 1));
+    return b < LATENCY_BUCKETS - 1 ? b : LATENCY_BUCKETS - 1;
+}
+
+// Cận trên (không bao gồm) của bucket b
+static uint32_t bucket_upper(uint32_t b)
+{
+    if (b < (1u << LATENCY_SUB_BITS))
+        return b + 1;
+    if (b >= LATENCY_BUCKETS - 1)
+        return UINT32_MAX;
+    uint32_t shift = (b >> LATENCY_SUB_BITS) - 1;
+    uint32_t lower = ((1u << LATENCY_SUB_BITS) | (b & ((1u << LATENCY_SUB_BITS) - 1))) << shift;
+    return lower + (1u << shift);
+}
+
+// Số mẫu chép ra khỏi ring mỗi lần vào hist_lock
+#define COLLECT_CHUNK 32
+
+// Chuyển các mẫu trong ring vào histogram. Mỗi đợt COLLECT_CHUNK mẫu được chép ra
+// dưới hist_lock; phép đổi chu kỳ -> ns (64 bit) và tìm bucket làm ngoài khóa, rồi
+// vào khóa lần nữa chỉ để cộng vào histogram. Không gọi khi đang giữ hist_lock.
+static void collect(void)
+{
+    uint32_t cycles_per_us = hal_cycles_per_us();
+    uint32_t n;
+    do
+    {
+        uint32_t sample[COLLECT_CHUNK], ns[COLLECT_CHUNK];
+        uint8_t stage[COLLECT_CHUNK], bucket[COLLECT_CHUNK];
+        n = 0;
+
+        portENTER_CRITICAL(&hist_lock);
+        uint32_t head = __atomic_load_n(&ring_head, __ATOMIC_ACQUIRE);
+        if (head - ring_tail > LATENCY_RING_SIZE)
+        {
+            // Phía ghi đã vòng qua các mẫu chưa đọc: bỏ phần bị ghi đè
+            ring_overruns += head - ring_tail - LATENCY_RING_SIZE;
+            ring_tail = head - LATENCY_RING_SIZE;
+        }
+        while (n < COLLECT_CHUNK && ring_tail != head)
+        {
+            uint32_t word = __atomic_exchange_n(&ring[ring_tail & (LATENCY_RING_SIZE - 1)], 0, __ATOMIC_ACQUIRE);
+            if (word == 0)
+                break; // Ô đã được cấp nhưng chưa ghi xong
+            ring_tail++;
+            sample[n++] = word;
+        }
+        portEXIT_CRITICAL(&hist_lock);
+
+        uint32_t valid = 0;
+        for (uint32_t i = 0; i < n; i++)
+        {
+            uint32_t s = (sample[i] >> SAMPLE_STAGE_SHIFT) - 1;
+            if (s >= LATENCY_STAGE_COUNT)
+                continue;
+            uint64_t v = (uint64_t)(sample[i] & SAMPLE_CYCLES_MASK) * 1000 / cycles_per_us;
+            ns[valid] = v > UINT32_MAX ? UINT32_MAX : (uint32_t)v;
+            bucket[valid] = (uint8_t)bucket_of(ns[valid]);
+            stage[valid++] = (uint8_t)s;
+        }
+        if (valid == 0)
+            continue;
+
+        portENTER_CRITICAL(&hist_lock);
+        for (uint32_t i = 0; i < valid; i++)
+        {
+            hist[stage[i]].count++;
+            hist[stage[i]].buckets[bucket[i]]++;
+            if (ns[i] > hist[stage[i]].max_ns)
+                hist[stage[i]].max_ns = ns[i];
+        }
+        portEXIT_CRITICAL(&hist_lock);
+    } while (n == COLLECT_CHUNK);
+}
+
+// Cận trên của bucket chứa phân vị pct, giới hạn bởi max thật
+static uint32_t percentile(const stage_hist_t *h, uint32_t pct)
+{
+    if (h->count == 0)
+        return 0;
+    uint32_t rank = (uint32_t)(((uint64_t)h->count * pct + 99) / 100);
+    uint32_t seen = 0;
+    for (uint32_t b = 0; b < LATENCY_BUCKETS; b++)
+    {
+        seen += h->buckets[b];
+        if (seen >= rank)
+        {
+            uint32_t upper = bucket_upper(b);
+            return upper < h->max_ns ? upper : h->max_ns;
+        }
+    }
+    return h->max_ns;
+}
+
+// Chép histogram của chặng ra dưới khóa rồi tính phân vị trên bản sao
+static void summarize(latency_stage_t stage, latency_summary_t *out)
+{
+    stage_hist_t h;
+    portENTER_CRITICAL(&hist_lock);
+    h = hist[stage];
+    portEXIT_CRITICAL(&hist_lock);
+
+    out->count = h.count;
+    out->p50_ns = percentile(&h, 50);
+    out->p99_ns = percentile(&h, 99);
+    out->max_ns = h.max_ns;
+}
+
+void latency_collect(void)
+{
+    collect();
+}
+
+void latency_get(latency_stage_t stage, latency_summary_t *out)
+{
+    collect();
+    summarize(stage, out);
+}
+
+size_t latency_format(char *buf, size_t len)
+{
+    size_t used = 0;
+    collect();
+    for (int s = 0; s < LATENCY_STAGE_COUNT && used < len; s++)
+    {
+        latency_summary_t sum;
+        summarize(s, &sum);
+        int n = snprintf(buf + used, len - used, "%-7s n=%u p50=%uns p99=%uns max=%uns\n",
+                         stage_names[s], (unsigned)sum.count, (unsigned)sum.p50_ns,
+                         (unsigned)sum.p99_ns, (unsigned)sum.max_ns);
+        if (n < 0)
+            break;
+        used += (size_t)n < len - used ? (size_t)n : len - used - 1;
+    }
+    if (used < len)
+    {
+        int n = snprintf(buf + used, len - used, "overruns=%u\n", (unsigned)ring_overruns);
+        if (n > 0)
+            used += (size_t)n < len - used ? (size_t)n : len - used - 1;
+    }
+    return used;
+}
+
+void latency_dump(void)
+{
+    char buf[LATENCY_STAGE_COUNT * 64 + 32];
+    latency_format(buf, sizeof(buf));
+
+    // Log từng dòng để giữ định dạng của ESP_LOG
+    char *save = NULL;
+    for (char *line = strtok_r(buf, "\n", &save); line; line = strtok_r(NULL, "\n", &save))
+        ESP_LOGI(TAG, "%s", line);
+}
+
+void latency_reset(void)
+{
+    collect();
+    portENTER_CRITICAL(&hist_lock);
+    memset(hist, 0, sizeof(hist));
+    ring_overruns = 0;
+    portEXIT_CRITICAL(&hist_lock);
+}
+
+#endif // LATENCY_TRACE
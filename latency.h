@@ -0,0 +1,118 @@
+#ifndef LATENCY_H
+#define LATENCY_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "hal.h"
+
+/*
+ * Đo thời gian từng chặng trên đường nhận gói -> điều khiển -> OLED.
+ * Đặt LATENCY_TRACE = 0 (mặc định khi có NDEBUG) để loại bỏ hoàn toàn lúc
+ * biên dịch: các macro bên dưới không sinh mã và latency.c rỗng.
+ */
+#ifndef LATENCY_TRACE
+#ifdef NDEBUG
+#define LATENCY_TRACE 0
+#else
+#define LATENCY_TRACE 1
+#endif
+#endif
+
+#define LATENCY_RING_SIZE 256 // Số mẫu chờ gộp vào histogram (lũy thừa của 2)
+#define LATENCY_SUB_BITS 2    // 4 bucket con mỗi quãng 2x (sai số bucket <= 25%)
+#define LATENCY_BUCKETS 100   // Bucket cuối gom mọi giá trị >= ~67 ms
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+    typedef enum
+    {
+        LATENCY_PARSE,   // recvfrom trả về -> gói được giải mã và chấp nhận
+        LATENCY_STEER,   // steering_angle()
+        LATENCY_ACTUATE, // servo_set_angle() + motor_control()
+        LATENCY_TOTAL,   // recvfrom trả về -> actuation xong
+        LATENCY_DISPLAY, // recvfrom trả về -> display task submit khung OLED (đo bằng hal_time_us)
+        LATENCY_WAKEUP,  // failsafe task (core/ưu tiên của nhóm điều khiển) thức dậy trễ so với chu kỳ
+        LATENCY_STAGE_COUNT,
+    } latency_stage_t;
+
+    /**
+     * @brief Tóm tắt histogram của một chặng (nano giây).
+     *
+     * p50/p99 là cận trên của bucket chứa phân vị; max là giá trị thật.
+     */
+    typedef struct
+    {
+        uint32_t count;
+        uint32_t p50_ns;
+        uint32_t p99_ns;
+        uint32_t max_ns;
+    } latency_summary_t;
+
+#if LATENCY_TRACE
+#define LATENCY_STAMP() hal_cycles()
+#define LATENCY_RECORD(stage, start) latency_record((stage), hal_cycles() - (start))
+#define LATENCY_RECORD_US(stage, start_us) latency_record_us((stage), hal_time_us() - (start_us))
+
+    /**
+     * @brief Ghi một mẫu vào ring buffer; không khóa, gọi được từ nhiều task.
+     *
+     * @param stage Chặng được đo.
+     * @param cycles Thời gian theo chu kỳ hal_cycles().
+     */
+    void latency_record(latency_stage_t stage, uint32_t cycles);
+
+    /**
+     * @brief Như latency_record() nhưng thời gian tính bằng micro giây.
+     *
+     * hal_cycles() đếm riêng từng core và hai bộ đếm không đồng bộ, nên chặng
+     * bắt đầu ở task này và kết thúc ở task khác (có thể khác core) phải đo bằng
+     * hal_time_us(). Chặng trong cùng một task vẫn dùng LATENCY_RECORD().
+     *
+     * @param stage Chặng được đo.
+     * @param us Thời gian theo hal_time_us().
+     */
+    void latency_record_us(latency_stage_t stage, int64_t us);
+
+    /**
+     * @brief Gộp các mẫu đang chờ trong ring vào histogram.
+     *
+     * Cần được gọi định kỳ (display task gọi mỗi khung) để ring không bị ghi đè.
+     */
+    void latency_collect(void);
+
+    /**
+     * @brief Gộp các mẫu đang chờ rồi lấy tóm tắt một chặng.
+     */
+    void latency_get(latency_stage_t stage, latency_summary_t *out);
+
+    /**
+     * @brief Ghi báo cáo dạng văn bản (một dòng mỗi chặng) vào buf.
+     *
+     * @return Số byte đã ghi (không tính '\0').
+     */
+    size_t latency_format(char *buf, size_t len);
+
+    /**
+     * @brief In báo cáo ra log.
+     */
+    void latency_dump(void);
+
+    /**
+     * @brief Xóa histogram và các mẫu đang chờ.
+     */
+    void latency_reset(void);
+#else
+#define LATENCY_STAMP() 0u
+#define LATENCY_RECORD(stage, start) ((void)(start))
+#define LATENCY_RECORD_US(stage, start_us) ((void)(start_us))
+#define latency_collect() ((void)0)
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // LATENCY_H
@@ -1,139 +1,504 @@
-#include "motor.h"
-#include "driver/ledc.h"
-#include "driver/gpio.h"
-#include <math.h>
-//---------------- Motor Functions ----------------
-
-// Initialize PWM for motor and configure direction GPIOs
-void pwm_init(void)
-{
-    ledc_timer_config_t ledc_timer = {
-        .speed_mode = LEDC_HIGH_SPEED_MODE,
-        .duty_resolution = LEDC_RES,
-        .timer_num = LEDC_TIMER_0,
-        .freq_hz = LEDC_FREQ,
-        .clk_cfg = LEDC_AUTO_CLK};
-    ledc_timer_config(&ledc_timer);
-
-    ledc_channel_config_t ledc_channel = {
-        .gpio_num = PWM_GPIO,
-        .speed_mode = LEDC_HIGH_SPEED_MODE,
-        .channel = LEDC_CHANNEL_0,
-        .timer_sel = LEDC_TIMER_0,
-        .duty = 0,
-        .hpoint = 0};
-    ledc_channel_config(&ledc_channel);
-
-    gpio_set_direction(RPWM_GPIO, GPIO_MODE_OUTPUT);
-    gpio_set_direction(LPWM_GPIO, GPIO_MODE_OUTPUT);
-}
-//---------------- Servo Functions ----------------
-
-// Initialize PWM for servo using SERVO_GPIO and the defined servo timer/channel
-void servo_init(void)
-{
-    // Configure timer for servo PWM on SERVO_LEDC_TIMER using low-speed mode
-    ledc_timer_config_t ledc_timer = {
-        .speed_mode = LEDC_LOW_SPEED_MODE,
-        .duty_resolution = LEDC_RES,
-        .timer_num = SERVO_LEDC_TIMER,
-        .freq_hz = SERVO_LEDC_FREQ,
-        .clk_cfg = LEDC_AUTO_CLK};
-    ledc_timer_config(&ledc_timer);
-
-    // Configure PWM channel for servo on SERVO_LEDC_CHANNEL and SERVO_GPIO
-    ledc_channel_config_t ledc_channel = {
-        .gpio_num = SERVO_GPIO,
-        .speed_mode = LEDC_LOW_SPEED_MODE,
-        .channel = SERVO_LEDC_CHANNEL,
-        .timer_sel = SERVO_LEDC_TIMER,
-        .duty = 0,
-        .hpoint = 0};
-    ledc_channel_config(&ledc_channel);
-}
-// Hàm điều khiển xe chạy tiến
-void motor_forward(uint32_t duty) {
-    gpio_set_level(RPWM_GPIO, 1);
-    gpio_set_level(LPWM_GPIO, 0);
-    ledc_set_duty(LEDC_HIGH_SPEED_MODE, LEDC_CHANNEL_0, duty);
-    ledc_update_duty(LEDC_HIGH_SPEED_MODE, LEDC_CHANNEL_0);
-}
-
-// Hàm điều khiển xe chạy lùi
-void motor_backward(uint32_t duty) {
-    gpio_set_level(RPWM_GPIO, 0);
-    gpio_set_level(LPWM_GPIO, 1);
-    ledc_set_duty(LEDC_HIGH_SPEED_MODE, LEDC_CHANNEL_0, duty);
-    ledc_update_duty(LEDC_HIGH_SPEED_MODE, LEDC_CHANNEL_0);
-}
-
-// Hàm dừng xe
-void motor_stop() {
-    gpio_set_level(RPWM_GPIO, 0);
-    gpio_set_level(LPWM_GPIO, 0);
-    ledc_set_duty(LEDC_HIGH_SPEED_MODE, LEDC_CHANNEL_0, 0);
-    ledc_update_duty(LEDC_HIGH_SPEED_MODE, LEDC_CHANNEL_0);
-}
-
-// Hàm tính tốc độ dựa trên tọa độ y
-// float calculate_speed(int j1y, int speed_max)
-// {
-//     return (speed_max * abs(j1y)) / (MAX_AXIS_VALUE * 1.0);
-// }
-
-// Hàm tính góc quay dựa trên giá trị j1x và j1y (giới hạn trong phạm vi MAX_ANGLE)
-float calculate_angle(int j1x, int j1y)
-{
-    // Tính góc quay từ tọa độ x và y
-    float angle = atan2(j1x, j1y) * (180 / 3.1415926535);
-    angle = -angle;
-    if (angle >= MAX_ANGLE)
-    {
-        angle -= MAX_ANGLE;
-    }
-    else if (angle <= -MAX_ANGLE)
-    {
-        angle += MAX_ANGLE;
-    }
-    return angle;
-}
-
-
-//hàm chuẩn hoá lại góc quay
-
-float normalize_angle(int angle) {
-    // Tính giá trị đã điều chỉnh, bắt đầu từ 0 sau khi loại bỏ 25 độ
-    float adjusted = fmax(fabs(angle) - 20, 0);
-    // Giới hạn giá trị tối đa là 60 độ
-    adjusted = fmin(adjusted, MAX_ANGLE_REAL);
-    // Gán lại dấu theo góc ban đầu
-    return copysign(adjusted, angle);
-}
-
-// Bảng hàm điều khiển động cơ
-void (*motor_functions[3])(uint32_t) = {motor_backward, motor_stop, motor_forward};
-
-// Hàm điều khiển motor theo tốc độ và góc quay mà không sử dụng if-else
-void motor_control(int j1y, uint32_t duty)
-{
-    uint32_t pwm_duty = (int)(abs(j1y) * SPEED_MAX / MAX_AXIS_VALUE);
-
-    int direction = (j1y > 0) - (j1y < 0);
-
-    motor_functions[direction + 1](pwm_duty);
-}  
-
-void servo_set_angle(uint32_t angle)
-{
-    // Clamp angle to maximum 180°
-    if (angle > 180)
-        angle = 180;
-
-    // Calculate duty values based on LEDC_RES (e.g., 10-bit: max 1023)
-    uint32_t duty_min = 51;  // Approximate duty for 1ms pulse (5% of 1023)
-    uint32_t duty_max = 102; // Approximate duty for 2ms pulse (10% of 1023)
-    uint32_t duty = duty_min + ((duty_max - duty_min) * angle) / 180;
-
-    ledc_set_duty(LEDC_LOW_SPEED_MODE, SERVO_LEDC_CHANNEL, duty);
-    ledc_update_duty(LEDC_LOW_SPEED_MODE, SERVO_LEDC_CHANNEL);
-}
+#include "motor.h"
+#include "hal.h"
+#include "sysmon.h"
+#include <stdlib.h>
+#include <math.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+#include <freertos/task.h>
+//---------------- Motor Functions ----------------
+
+/*
+ * Ramp ga: duty motor được chuyển bằng bộ fade phần cứng của LEDC
+ * (hal_pwm_fade_to), CPU không phải làm gì trong lúc fade. Khi đổi chiều,
+ * duty luôn được đưa về 0 trước; fade về 0 xong thì ISR của LEDC đánh thức
+ * motor_ramp_task để đảo RPWM/LPWM và bắt đầu fade tới duty mới. Lệnh mới
+ * đến giữa chừng chỉ đổi đích, fade đang chạy được dừng tại duty hiện tại.
+ */
+
+// Chiều đang đặt trên RPWM/LPWM: 1 tiến, -1 lùi, 0 dừng
+static int motor_direction = 0;
+// Chiều và duty đích; target_dir khác motor_direction nghĩa là đang chờ qua 0
+static int target_dir = 0;
+static uint32_t target_duty = 0;
+// Đang phanh: RPWM = LPWM = 1, lệnh kế tiếp bỏ phanh ngay không cần ramp
+static bool braked = false;
+
+static uint32_t ramp_accel_ms = MOTOR_ACCEL_MS;
+static uint32_t ramp_decel_ms = MOTOR_DECEL_MS;
+
+static TaskHandle_t ramp_task_handle = NULL;
+
+// Servo: hiệu chỉnh, tần số làm tươi và xung đang xuất (0 = chưa xuất xung)
+static servo_calibration_t servo_cal = {SERVO_PULSE_MIN_US, SERVO_PULSE_CENTER_US, SERVO_PULSE_MAX_US};
+static uint32_t servo_freq_hz = SERVO_LEDC_FREQ;
+static uint32_t servo_pulse = 0;
+static uint32_t servo_hysteresis_us = SERVO_HYSTERESIS_US;
+
+// Khóa giữa các task cùng ghi servo/motor (UDP task, failsafe task, ramp task)
+static SemaphoreHandle_t actuator_mutex = NULL;
+
+/*===================== Actuator cache =====================*/
+/*
+ * Giữ trạng thái đã ghi ra phần cứng của từng output và bỏ qua lần ghi không
+ * làm thay đổi gì (joystick giữ yên vẫn gửi gói đều đặn). Mọi hàm ghi đều
+ * được gọi khi đang giữ actuator_mutex.
+ */
+static int8_t bridge_level[2] = {-1, -1}; // RPWM, LPWM; -1 = chưa ghi
+static uint32_t motor_pwm_target = 0;     // Duty đích của lần ghi/fade motor gần nhất
+static uint32_t servo_duty = UINT32_MAX;  // Duty servo đã ghi; UINT32_MAX = chưa ghi
+static actuator_stats_t actuator_stats;
+
+static void actuator_count(actuator_counter_t *counter, bool issued)
+{
+    if (issued)
+        counter->issued++;
+    else
+        counter->suppressed++;
+}
+
+static void bridge_write(int index, int gpio, uint32_t level)
+{
+    bool issued = bridge_level[index] != (int8_t)level;
+    if (issued)
+    {
+        hal_gpio_set_level(gpio, level);
+        bridge_level[index] = (int8_t)level;
+    }
+    actuator_count(&actuator_stats.bridge_gpio, issued);
+}
+
+static void bridge_set(int dir)
+{
+    bridge_write(0, RPWM_GPIO, dir > 0);
+    bridge_write(1, LPWM_GPIO, dir < 0);
+    motor_direction = dir;
+}
+
+// Ghi duty motor (time_ms = 0) hoặc bắt đầu fade. Bỏ qua khi đang fade tới đúng
+// duty đó, hoặc khi ghi ngay mà duty phần cứng đã bằng giá trị cần ghi.
+static void motor_pwm_write(uint32_t duty, uint32_t time_ms)
+{
+    bool issued = time_ms > 0 ? duty != motor_pwm_target : hal_pwm_get_duty(HAL_PWM_MOTOR) != duty;
+    if (issued)
+    {
+        hal_pwm_fade_to(HAL_PWM_MOTOR, duty, time_ms);
+        motor_pwm_target = duty;
+    }
+    actuator_count(&actuator_stats.motor_pwm, issued);
+}
+
+// Thời gian fade từ from tới to, tỉ lệ với độ chênh so với toàn dải duty
+static uint32_t ramp_time(uint32_t from, uint32_t to, uint32_t full_scale_ms)
+{
+    uint32_t delta = from > to ? from - to : to - from;
+    return (uint32_t)(((uint64_t)delta * full_scale_ms) >> LEDC_RES_BITS);
+}
+
+// Đưa motor về phía (target_dir, target_duty); gọi khi đang giữ actuator_mutex
+static void motor_ramp_apply(uint32_t decel_ms)
+{
+    uint32_t current = hal_pwm_get_duty(HAL_PWM_MOTOR);
+    if (braked)
+    {
+        motor_pwm_write(0, 0);
+        current = 0;
+        braked = false;
+        bridge_set(0);
+    }
+
+    if (target_dir != motor_direction)
+    {
+        uint32_t ms = ramp_time(current, 0, decel_ms);
+        if (current != 0 && ms > 0)
+        {
+            // Bắt buộc qua 0 trước khi đảo chiều; motor_ramp_task làm tiếp khi fade xong
+            motor_pwm_write(0, ms);
+            return;
+        }
+        if (current != 0)
+            motor_pwm_write(0, 0);
+        current = 0;
+        bridge_set(target_dir);
+    }
+
+    uint32_t duty = target_dir == 0 ? 0 : target_duty;
+    uint32_t full_ms = duty > current ? ramp_accel_ms : decel_ms;
+    motor_pwm_write(duty, ramp_time(current, duty, full_ms));
+}
+
+static void motor_drive(int dir, uint32_t duty)
+{
+    target_dir = dir;
+    target_duty = duty;
+    motor_ramp_apply(ramp_decel_ms);
+}
+
+// ISR của LEDC: fade motor kết thúc
+static bool motor_fade_done(hal_pwm_channel_t channel, void *arg)
+{
+    BaseType_t woken = pdFALSE;
+    if (ramp_task_handle != NULL)
+        vTaskNotifyGiveFromISR(ramp_task_handle, &woken);
+    return woken == pdTRUE;
+}
+
+// Hoàn tất bước qua 0 khi đổi chiều; các fade khác kết thúc không cần làm gì thêm
+static void motor_ramp_task(void *pvParameters)
+{
+    while (1)
+    {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        motor_lock();
+        if (target_dir != motor_direction && hal_pwm_get_duty(HAL_PWM_MOTOR) == 0)
+            motor_ramp_apply(ramp_decel_ms);
+        motor_unlock();
+    }
+}
+
+SYSMON_MUTEX_STORAGE(actuator);
+SYSMON_TASK_STORAGE(motor_ramp, TASK_MOTOR_RAMP_STACK);
+
+// Initialize PWM for motor and configure direction GPIOs
+void pwm_init(void)
+{
+    if (actuator_mutex == NULL)
+        actuator_mutex = SYSMON_MUTEX_CREATE(actuator);
+
+    hal_pwm_init(HAL_PWM_MOTOR, PWM_GPIO, LEDC_FREQ, LEDC_RES_BITS);
+
+    hal_gpio_set_output(RPWM_GPIO);
+    hal_gpio_set_output(LPWM_GPIO);
+
+    if (ramp_task_handle == NULL)
+    {
+        SYSMON_TASK_CREATE(motor_ramp, motor_ramp_task, "motor_ramp", NULL, TASK_MOTOR_RAMP_PRIO, TASK_MOTOR_RAMP_CORE, &ramp_task_handle);
+        hal_pwm_set_fade_callback(HAL_PWM_MOTOR, motor_fade_done, NULL);
+    }
+}
+//---------------- Servo Functions ----------------
+
+// Initialize PWM for servo using SERVO_GPIO (low-speed LEDC timer/channel, see hal_esp32.c)
+void servo_init(void)
+{
+    hal_pwm_init(HAL_PWM_SERVO, SERVO_GPIO, servo_freq_hz, SERVO_LEDC_RES_BITS);
+}
+
+// Ghi xung servo_pulse ra kênh theo tần số hiện tại; bỏ qua nếu duty không đổi
+static esp_err_t servo_write(void)
+{
+    uint64_t duty = ((uint64_t)servo_pulse * servo_freq_hz << SERVO_LEDC_RES_BITS) + 500000;
+    duty /= 1000000;
+    bool issued = duty != servo_duty;
+    actuator_count(&actuator_stats.servo_pwm, issued);
+    if (!issued)
+        return ESP_OK;
+    servo_duty = (uint32_t)duty;
+    return hal_pwm_set_duty(HAL_PWM_SERVO, servo_duty);
+}
+
+// Đặt độ rộng xung servo (us), giới hạn trong [min_us, max_us] của hiệu chỉnh.
+// Thay đổi nhỏ hơn servo_hysteresis_us so với xung đang xuất bị bỏ qua để servo
+// không rung giữa hai góc kề nhau; hai đầu hành trình luôn được ghi.
+esp_err_t servo_set_pulse_us(uint32_t pulse_us)
+{
+    if (pulse_us < servo_cal.min_us)
+        pulse_us = servo_cal.min_us;
+    else if (pulse_us > servo_cal.max_us)
+        pulse_us = servo_cal.max_us;
+
+    uint32_t delta = pulse_us > servo_pulse ? pulse_us - servo_pulse : servo_pulse - pulse_us;
+    if (servo_pulse != 0 && delta < servo_hysteresis_us &&
+        pulse_us != servo_cal.min_us && pulse_us != servo_cal.max_us)
+    {
+        actuator_count(&actuator_stats.servo_pwm, false);
+        return ESP_OK;
+    }
+    servo_pulse = pulse_us;
+    return servo_write();
+}
+
+void servo_set_hysteresis_us(uint32_t hysteresis_us)
+{
+    motor_lock();
+    servo_hysteresis_us = hysteresis_us;
+    motor_unlock();
+}
+
+// Hiệu chỉnh riêng cho từng servo; xung đang xuất được giới hạn lại theo hiệu chỉnh mới
+esp_err_t servo_calibrate(const servo_calibration_t *cal)
+{
+    if (cal == NULL || cal->min_us >= cal->center_us || cal->center_us >= cal->max_us ||
+        cal->max_us >= 1000000 / servo_freq_hz)
+        return ESP_ERR_INVALID_ARG;
+
+    motor_lock();
+    servo_cal = *cal;
+    esp_err_t err = servo_pulse ? servo_set_pulse_us(servo_pulse) : ESP_OK;
+    motor_unlock();
+    return err;
+}
+
+void servo_get_calibration(servo_calibration_t *cal)
+{
+    *cal = servo_cal;
+}
+
+// Đổi tần số làm tươi (servo số chịu được 200-333 Hz); chu kỳ phải dài hơn xung max_us
+esp_err_t servo_set_refresh_hz(uint32_t freq_hz)
+{
+    if (freq_hz == 0 || 1000000 / freq_hz <= servo_cal.max_us)
+        return ESP_ERR_INVALID_ARG;
+
+    motor_lock();
+    esp_err_t err = hal_pwm_set_freq(HAL_PWM_SERVO, freq_hz);
+    if (err == ESP_OK)
+    {
+        servo_freq_hz = freq_hz;
+        if (servo_pulse)
+            err = servo_write();
+    }
+    motor_unlock();
+    return err;
+}
+// Hàm điều khiển xe chạy tiến (duty đạt được sau thời gian ramp)
+void motor_forward(uint32_t duty) {
+    motor_drive(1, duty);
+}
+
+// Hàm điều khiển xe chạy lùi (duty đạt được sau thời gian ramp)
+void motor_backward(uint32_t duty) {
+    motor_drive(-1, duty);
+}
+
+// Hàm dừng xe: giảm duty về 0 theo ramp giảm tốc rồi nhả cả hai chân
+void motor_stop() {
+    motor_drive(0, 0);
+}
+
+// Thả trôi: giảm duty về 0 trong ramp_ms (tính cho toàn dải duty) rồi nhả cả hai chân
+void motor_coast(uint32_t ramp_ms)
+{
+    target_dir = 0;
+    target_duty = 0;
+    motor_ramp_apply(ramp_ms);
+}
+
+// Hàm phanh: cả hai nửa cầu H cùng mức, hai cực motor bị nối tắt; không ramp
+void motor_brake(void) {
+    target_dir = 0;
+    target_duty = 0;
+    braked = true;
+    motor_direction = 0;
+    bridge_write(0, RPWM_GPIO, 1);
+    bridge_write(1, LPWM_GPIO, 1);
+    motor_pwm_write((1u << LEDC_RES_BITS) - 1, 0);
+}
+
+void motor_set_ramp(uint32_t accel_ms, uint32_t decel_ms)
+{
+    motor_lock();
+    ramp_accel_ms = accel_ms;
+    ramp_decel_ms = decel_ms;
+    motor_unlock();
+}
+
+void motor_lock(void)
+{
+    if (actuator_mutex != NULL)
+        xSemaphoreTake(actuator_mutex, portMAX_DELAY);
+}
+
+void motor_unlock(void)
+{
+    if (actuator_mutex != NULL)
+        xSemaphoreGive(actuator_mutex);
+}
+
+void actuator_get_stats(actuator_stats_t *out)
+{
+    motor_lock();
+    *out = actuator_stats;
+    motor_unlock();
+}
+
+int motor_get_direction(void)
+{
+    return motor_direction;
+}
+
+// Hàm tính tốc độ dựa trên tọa độ y
+// float calculate_speed(int j1y, int speed_max)
+// {
+//     return (speed_max * abs(j1y)) / (MAX_AXIS_VALUE * 1.0);
+// }
+
+// Hàm tính góc quay dựa trên giá trị j1x và j1y (giới hạn trong phạm vi MAX_ANGLE)
+// Bản float gốc, giữ làm tham chiếu cho steering_angle()
+float calculate_angle(int j1x, int j1y)
+{
+    // Tính góc quay từ tọa độ x và y
+    float angle = atan2(j1x, j1y) * (180 / 3.1415926535);
+    angle = -angle;
+    if (angle >= MAX_ANGLE)
+    {
+        angle -= MAX_ANGLE;
+    }
+    else if (angle <= -MAX_ANGLE)
+    {
+        angle += MAX_ANGLE;
+    }
+    return angle;
+}
+
+
+//hàm chuẩn hoá lại góc quay
+
+float normalize_angle(int angle) {
+    // Tính giá trị đã điều chỉnh, bắt đầu từ 0 sau khi loại bỏ 25 độ
+    float adjusted = fmax(fabs(angle) - 20, 0);
+    // Giới hạn giá trị tối đa là 60 độ
+    adjusted = fmin(adjusted, MAX_ANGLE_REAL);
+    // Gán lại dấu theo góc ban đầu
+    return copysign(adjusted, angle);
+}
+
+//---------------- Steering (fixed-point) ----------------
+
+// Bảng atan trên một octant: steer_atan_q16[i] = atan(i / STEER_ATAN_STEPS) tính theo độ, Q16.
+// Sinh lúc biên dịch từ đa thức Abramowitz & Stegun 4.4.49 (sai số <= 2e-8 rad),
+// lúc chạy không dùng số thực.
+#define STEER_ATAN_STEPS 128
+#define STEER_Q 16
+#define STEER_DEG(d) ((int32_t)(d) << STEER_Q)
+
+#define STEER_X(i) ((double)(i) / STEER_ATAN_STEPS)
+#define STEER_X2(i) (STEER_X(i) * STEER_X(i))
+#define STEER_ATAN_RAD(i)                                                      \
+    (STEER_X(i) * (1.0 + STEER_X2(i) * (-0.3333314528 + STEER_X2(i) *          \
+    (0.1999355085 + STEER_X2(i) * (-0.1420889944 + STEER_X2(i) *               \
+    (0.1065626393 + STEER_X2(i) * (-0.0752896400 + STEER_X2(i) *               \
+    (0.0429096138 + STEER_X2(i) * (-0.0161657367 + STEER_X2(i) *               \
+    0.0028662257)))))))))
+#define STEER_ATAN_Q16(i) ((int32_t)(STEER_ATAN_RAD(i) * (180.0 / 3.14159265358979) * (1 << STEER_Q) + 0.5))
+
+#define STEER_A4(i) STEER_ATAN_Q16(i), STEER_ATAN_Q16(i + 1), STEER_ATAN_Q16(i + 2), STEER_ATAN_Q16(i + 3)
+#define STEER_A16(i) STEER_A4(i), STEER_A4(i + 4), STEER_A4(i + 8), STEER_A4(i + 12)
+#define STEER_A64(i) STEER_A16(i), STEER_A16(i + 16), STEER_A16(i + 32), STEER_A16(i + 48)
+
+static const int32_t steer_atan_q16[STEER_ATAN_STEPS + 1] = {
+    STEER_A64(0), STEER_A64(64), STEER_ATAN_Q16(STEER_ATAN_STEPS)};
+
+// Góc lái theo độ, tính hoàn toàn bằng số nguyên. Cho cùng kết quả với
+// normalize_angle(calculate_angle(j1x, j1y)): góc atan2 đảo dấu, gập về (-90, 90),
+// cắt phần lẻ về 0, bỏ vùng chết 20 độ rồi giới hạn ở MAX_ANGLE_REAL.
+int steering_angle(int16_t j1x, int16_t j1y)
+{
+    uint32_t ax = j1x < 0 ? (uint32_t)(-(int32_t)j1x) : (uint32_t)j1x;
+    uint32_t ay = j1y < 0 ? (uint32_t)(-(int32_t)j1y) : (uint32_t)j1y;
+    uint32_t lo = ax < ay ? ax : ay;
+    uint32_t hi = ax < ay ? ay : ax;
+
+    // theta = atan2(|x|, |y|) theo độ Q16, thu về octant [0, 45] rồi mở rộng ra [0, 180]
+    int32_t theta = 0;
+    if (hi != 0)
+    {
+        uint32_t scaled = lo * STEER_ATAN_STEPS;
+        uint32_t i = scaled / hi;
+        uint32_t rem = scaled % hi;
+        theta = steer_atan_q16[i];
+        if (rem != 0)
+        {
+            // Nội suy tuyến tính; phần lẻ lấy từ phần dư nên không mất độ chính xác của tỉ số
+            uint32_t frac = (rem << STEER_Q) / hi;
+            uint32_t step = (uint32_t)(steer_atan_q16[i + 1] - steer_atan_q16[i]);
+            theta += (int32_t)((step * frac) >> STEER_Q);
+        }
+        if (ax > ay)
+            theta = STEER_DEG(90) - theta;
+    }
+    if (j1y < 0)
+        theta = STEER_DEG(180) - theta;
+
+    // angle = -atan2(x, y); x = 0 cho atan2 dương (0 hoặc 180 độ)
+    int32_t angle = j1x < 0 ? theta : -theta;
+    if (angle >= STEER_DEG(MAX_ANGLE))
+        angle -= STEER_DEG(MAX_ANGLE);
+    else if (angle <= -STEER_DEG(MAX_ANGLE))
+        angle += STEER_DEG(MAX_ANGLE);
+
+    // Cắt về 0 như phép ép float -> int, sau đó vùng chết và giới hạn
+    int32_t deg = (angle < 0 ? -angle : angle) >> STEER_Q;
+    deg = deg > 20 ? deg - 20 : 0;
+    if (deg > MAX_ANGLE_REAL)
+        deg = MAX_ANGLE_REAL;
+    return angle < 0 ? -deg : deg;
+}
+
+//---------------- Throttle profiles ----------------
+
+// Mỗi profile là một bảng |j1Y| (0..MAX_AXIS_VALUE) -> duty LEDC, sinh lúc biên dịch:
+// duty = cap * ((1 - expo) * x + expo * x^3), x = |j1Y| / MAX_AXIS_VALUE.
+// expo càng lớn thì nửa đầu hành trình joystick càng mịn.
+#define THR_X(i) ((double)(i) / MAX_AXIS_VALUE)
+#define THR_DUTY(i, cap, expo) \
+    ((uint16_t)((cap) * ((1.0 - (expo)) * THR_X(i) + (expo) * THR_X(i) * THR_X(i) * THR_X(i)) + 0.5))
+
+#define THR_4(i, c, e) THR_DUTY(i, c, e), THR_DUTY(i + 1, c, e), THR_DUTY(i + 2, c, e), THR_DUTY(i + 3, c, e)
+#define THR_16(i, c, e) THR_4(i, c, e), THR_4(i + 4, c, e), THR_4(i + 8, c, e), THR_4(i + 12, c, e)
+#define THR_32(i, c, e) THR_16(i, c, e), THR_16(i + 16, c, e)
+#define THR_64(i, c, e) THR_32(i, c, e), THR_32(i + 32, c, e)
+#define THR_TABLE(c, e) {THR_64(0, c, e), THR_32(64, c, e), THR_4(96, c, e), THR_DUTY(100, c, e)}
+
+_Static_assert(MAX_AXIS_VALUE == 100, "THR_TABLE expects 101 entries");
+
+static const uint16_t throttle_table[THROTTLE_PROFILE_COUNT][MAX_AXIS_VALUE + 1] = {
+    [THROTTLE_PRECISION] = THR_TABLE(THROTTLE_PRECISION_CAP, 0.5),
+    [THROTTLE_NORMAL] = THR_TABLE(THROTTLE_NORMAL_CAP, 0.3),
+    [THROTTLE_NITRO] = THR_TABLE(THROTTLE_NITRO_CAP, 0.0),
+};
+
+throttle_profile_t throttle_select(int speed)
+{
+    if (speed < 0)
+        return THROTTLE_PRECISION;
+    return speed >= THROTTLE_NITRO_SPEED ? THROTTLE_NITRO : THROTTLE_NORMAL;
+}
+
+// Duty cho |j1y| theo profile; j1y ngoài dải được giới hạn ở MAX_AXIS_VALUE
+uint32_t throttle_duty(throttle_profile_t profile, int j1y)
+{
+    int mag = abs(j1y);
+    if (mag > MAX_AXIS_VALUE)
+        mag = MAX_AXIS_VALUE;
+    return throttle_table[profile][mag];
+}
+
+// Bảng hàm điều khiển động cơ
+void (*motor_functions[3])(uint32_t) = {motor_backward, motor_stop, motor_forward};
+
+// Hàm điều khiển motor theo j1Y và profile ga chọn bởi speed, không sử dụng if-else
+void motor_control(int j1y, int speed)
+{
+    uint32_t pwm_duty = throttle_duty(throttle_select(speed), j1y);
+
+    int direction = (j1y > 0) - (j1y < 0);
+
+    motor_functions[direction + 1](pwm_duty);
+}  
+
+void servo_set_angle(uint32_t angle)
+{
+    // Clamp angle to maximum 180°
+    if (angle > 180)
+        angle = 180;
+
+    // Nội suy tuyến tính từng nửa: 0..90 độ -> min..center, 90..180 độ -> center..max
+    uint32_t pulse_us;
+    if (angle <= 90)
+        pulse_us = servo_cal.min_us + ((servo_cal.center_us - servo_cal.min_us) * angle + 45) / 90;
+    else
+        pulse_us = servo_cal.center_us + ((servo_cal.max_us - servo_cal.center_us) * (angle - 90) + 45) / 90;
+
+    servo_set_pulse_us(pulse_us);
+}
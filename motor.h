@@ -1,47 +1,128 @@
-#ifndef MOTOR_H
-#define MOTOR_H
-
-#include <stdint.h>
-
-#ifdef __cplusplus
-extern "C"
-{
-#endif
-
-// Motor configuration
-#define PWM_GPIO 5
-#define RPWM_GPIO 18
-#define LPWM_GPIO 19
-
-#define LEDC_FREQ 1000
-#define LEDC_RES LEDC_TIMER_10_BIT
-
-// Servo configuration
-#define SERVO_GPIO 13
-#define SERVO_LEDC_FREQ 50
-#define SERVO_LEDC_TIMER LEDC_TIMER_1
-#define SERVO_LEDC_CHANNEL LEDC_CHANNEL_1
-
-#define MAX_AXIS_VALUE 100
-#define SPEED_MAX 1024
-#define MAX_ANGLE 90
-#define MAX_ANGLE_REAL 60
-
-    // Function prototypes
-    void pwm_init(void);
-    void motor_forward(uint32_t duty);
-    void motor_backward(uint32_t duty);
-    void motor_stop();
-
-    void servo_init(void);
-    void servo_set_angle(uint32_t angle);
-    void motor_control(int j1y, uint32_t duty);
-    float calculate_speed(int j1y, int speed_max);
-    float calculate_angle(int j1x, int j1y);
-    float normalize_angle(int angle);
-
-#ifdef __cplusplus
-}
-#endif
-
-#endif // MOTOR_H
+#ifndef MOTOR_H
+#define MOTOR_H
+
+#include <stdint.h>
+#include <esp_err.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+// Motor configuration
+#define PWM_GPIO 5
+#define RPWM_GPIO 18
+#define LPWM_GPIO 19
+
+#define LEDC_FREQ 1000
+#define LEDC_RES_BITS 10
+
+// Thời gian ramp của motor cho toàn dải duty (0 -> tối đa), thực hiện bằng fade LEDC
+#define MOTOR_ACCEL_MS 400
+#define MOTOR_DECEL_MS 250
+
+// Servo configuration
+#define SERVO_GPIO 13
+#define SERVO_LEDC_FREQ 50
+// Timer riêng cho servo: 16 bit ở 50 Hz là ~0.3 us mỗi bước duty
+#define SERVO_LEDC_RES_BITS 16
+
+// Hiệu chỉnh mặc định của servo (độ rộng xung, us); có thể ghi đè khi build
+// cho từng xe hoặc đổi lúc chạy bằng servo_calibrate()
+#ifndef SERVO_PULSE_MIN_US
+#define SERVO_PULSE_MIN_US 1000
+#endif
+#ifndef SERVO_PULSE_CENTER_US
+#define SERVO_PULSE_CENTER_US 1500
+#endif
+#ifndef SERVO_PULSE_MAX_US
+#define SERVO_PULSE_MAX_US 2000
+#endif
+// Thay đổi xung servo nhỏ hơn ngưỡng này bị bỏ qua; 1 độ ~5.6 us với hiệu chỉnh mặc định
+// (5 hoặc 6 us sau làm tròn) nên ngưỡng phải nhỏ hơn một bước góc, chỉ lọc rung dưới 1 độ
+#ifndef SERVO_HYSTERESIS_US
+#define SERVO_HYSTERESIS_US 3
+#endif
+
+#define MAX_AXIS_VALUE 100
+#define SPEED_MAX 1024
+#define MAX_ANGLE 90
+#define MAX_ANGLE_REAL 60
+
+// Profile ga, chọn theo trường speed của gói điều khiển:
+// speed < 0 -> PRECISION, speed >= THROTTLE_NITRO_SPEED -> NITRO, còn lại NORMAL
+#define THROTTLE_NITRO_SPEED 100
+// Duty tối đa của từng profile (toàn dải 10 bit là 1023)
+#define THROTTLE_PRECISION_CAP 358
+#define THROTTLE_NORMAL_CAP 767
+#define THROTTLE_NITRO_CAP ((1 << LEDC_RES_BITS) - 1)
+
+    /**
+     * @brief Độ rộng xung servo ở góc 0, 90 và 180 độ (us).
+     */
+    typedef struct
+    {
+        uint16_t min_us;
+        uint16_t center_us;
+        uint16_t max_us;
+    } servo_calibration_t;
+
+    /**
+     * @brief Số lần ghi ra phần cứng và số lần bị bỏ qua vì không thay đổi gì.
+     */
+    typedef struct
+    {
+        uint32_t issued;
+        uint32_t suppressed;
+    } actuator_counter_t;
+
+    typedef struct
+    {
+        actuator_counter_t motor_pwm;   // Duty/fade kênh motor
+        actuator_counter_t bridge_gpio; // RPWM/LPWM, tính từng chân
+        actuator_counter_t servo_pwm;   // Duty servo (kể cả bỏ qua do hysteresis)
+    } actuator_stats_t;
+
+    typedef enum
+    {
+        THROTTLE_PRECISION = 0,
+        THROTTLE_NORMAL,
+        THROTTLE_NITRO,
+        THROTTLE_PROFILE_COUNT
+    } throttle_profile_t;
+
+    // Function prototypes
+    void pwm_init(void);
+    void motor_forward(uint32_t duty);
+    void motor_backward(uint32_t duty);
+    void motor_stop();
+    void motor_brake(void);
+    void motor_coast(uint32_t ramp_ms);
+    void motor_set_ramp(uint32_t accel_ms, uint32_t decel_ms);
+    int motor_get_direction(void);
+    void actuator_get_stats(actuator_stats_t *out);
+
+    // Giữ khóa trong lúc ghi servo/motor khi có nhiều task cùng điều khiển
+    void motor_lock(void);
+    void motor_unlock(void);
+
+    void servo_init(void);
+    void servo_set_angle(uint32_t angle);
+    esp_err_t servo_set_pulse_us(uint32_t pulse_us);
+    esp_err_t servo_calibrate(const servo_calibration_t *cal);
+    void servo_get_calibration(servo_calibration_t *cal);
+    esp_err_t servo_set_refresh_hz(uint32_t freq_hz);
+    void servo_set_hysteresis_us(uint32_t hysteresis_us);
+    void motor_control(int j1y, int speed);
+    throttle_profile_t throttle_select(int speed);
+    uint32_t throttle_duty(throttle_profile_t profile, int j1y);
+    float calculate_speed(int j1y, int speed_max);
+    float calculate_angle(int j1x, int j1y);
+    float normalize_angle(int angle);
+    int steering_angle(int16_t j1x, int16_t j1y);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // MOTOR_H
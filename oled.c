@@ -1,611 +1,802 @@
-#include "oled.h"
-#include "esp_log.h"
-#include <stdio.h>
-#include <stdlib.h>
-#include <string.h>
-#include <stdarg.h>
-#include "qrcode.h"
-
-static const char *TAG = "OLED";
-
-// Bộ đệm hiển thị
-static uint8_t oled_buffer[OLED_BUFFER_SIZE];
-
-/*=================== I2C Init ===================*/
-static esp_err_t i2c_master_init(void)
-{
-    i2c_config_t conf = {
-        .mode = I2C_MODE_MASTER,
-        .sda_io_num = I2C_MASTER_SDA_IO,
-        .scl_io_num = I2C_MASTER_SCL_IO,
-        .sda_pullup_en = GPIO_PULLUP_ENABLE,
-        .scl_pullup_en = GPIO_PULLUP_ENABLE,
-        .master.clk_speed = I2C_MASTER_FREQ_HZ,
-    };
-    esp_err_t err = i2c_param_config(I2C_MASTER_NUM, &conf);
-    if (err != ESP_OK)
-    {
-        ESP_LOGE(TAG, "I2C param config failed");
-        return err;
-    }
-    return i2c_driver_install(I2C_MASTER_NUM, conf.mode, 0, 0, 0);
-}
-
-/*=================== SSD1306 Driver ====================*/
-// Gửi lệnh cho SSD1306 (prefix 0x00)
-static esp_err_t ssd1306_send_command(uint8_t cmd)
-{
-    uint8_t data[2] = {0x00, cmd};
-    return i2c_master_write_to_device(I2C_MASTER_NUM, OLED_ADDR, data, sizeof(data), 1000 / portTICK_PERIOD_MS);
-}
-
-// Gửi dữ liệu cho SSD1306 (prefix 0x40)
-static esp_err_t ssd1306_send_data(uint8_t *data_ptr, size_t len)
-{
-    uint8_t *data = malloc(len + 1);
-    if (!data)
-        return ESP_ERR_NO_MEM;
-    data[0] = 0x40; // Data mode
-    memcpy(&data[1], data_ptr, len);
-    esp_err_t err = i2c_master_write_to_device(I2C_MASTER_NUM, OLED_ADDR, data, len + 1, 1000 / portTICK_PERIOD_MS);
-    free(data);
-    return err;
-}
-
-// Hàm khởi tạo SSD1306 (theo datasheet)
-static void ssd1306_init(void)
-{
-    vTaskDelay(100 / portTICK_PERIOD_MS);
-    ssd1306_send_command(0xAE); // Display OFF
-    ssd1306_send_command(0x20); // Set Memory Addressing Mode
-    ssd1306_send_command(0x00); // Horizontal Addressing Mode
-    ssd1306_send_command(0xB0); // Set Page Start Address cho Page Addressing Mode (0-7)
-    ssd1306_send_command(0xC8); // COM Output Scan Direction (remapped)
-    ssd1306_send_command(0x00); // Low Column Address
-    ssd1306_send_command(0x10); // High Column Address
-    ssd1306_send_command(0x40); // Start Line Address
-    ssd1306_send_command(0x81); // Set Contrast Control
-    ssd1306_send_command(0xFF);
-    ssd1306_send_command(0xA1); // Segment Re-map
-    ssd1306_send_command(0xA6); // Normal Display
-    ssd1306_send_command(0xA8); // Set Multiplex Ratio
-    ssd1306_send_command(0x3F);
-    ssd1306_send_command(0xA4); // Output follows RAM content
-    ssd1306_send_command(0xD3); // Set Display Offset
-    ssd1306_send_command(0x00);
-    ssd1306_send_command(0xD5); // Set Display Clock Divide Ratio/Oscillator Frequency
-    ssd1306_send_command(0xF0);
-    ssd1306_send_command(0xD9); // Set Pre-charge Period
-    ssd1306_send_command(0x22);
-    ssd1306_send_command(0xDA); // Set COM Pins Hardware Configuration
-    ssd1306_send_command(0x12);
-    ssd1306_send_command(0xDB); // Set VCOMH Deselect Level
-    ssd1306_send_command(0x20);
-    ssd1306_send_command(0x8D); // Charge Pump Setting
-    ssd1306_send_command(0x14); // Enable Charge Pump
-    ssd1306_send_command(0xAF); // Display ON
-}
-
-/*=================== Font 5x7 ====================*/
-// Hàm trả về con trỏ đến mảng 5 byte định nghĩa một ký tự 5x7
-static const uint8_t *get_font_data(char c)
-{
-    switch (c)
-    {
-    // ----------- Ký tự ASCII cơ bản -----------
-    // Ký tự khoảng trắng
-    case ' ':
-    {
-        static const uint8_t data[5] = {0x00, 0x00, 0x00, 0x00, 0x00};
-        return data;
-    }
-    // Chữ thường
-    case 'a':
-    {
-        static const uint8_t data[5] = {0x20, 0x54, 0x54, 0x54, 0x78};
-        return data;
-    }
-    case 'b':
-    {
-        static const uint8_t data[5] = {0x7F, 0x48, 0x44, 0x44, 0x38};
-        return data;
-    }
-    case 'c':
-    {
-        static const uint8_t data[5] = {0x38, 0x44, 0x44, 0x44, 0x20};
-        return data;
-    }
-    case 'd':
-    {
-        static const uint8_t data[5] = {0x38, 0x44, 0x44, 0x48, 0x7F};
-        return data;
-    }
-    case 'e':
-    {
-        static const uint8_t data[5] = {0x38, 0x54, 0x54, 0x54, 0x18};
-        return data;
-    }
-    case 'f':
-    {
-        static const uint8_t data[5] = {0x08, 0x7E, 0x09, 0x01, 0x02};
-        return data;
-    }
-    case 'g':
-    {
-        static const uint8_t data[5] = {0x0C, 0x52, 0x52, 0x52, 0x3E};
-        return data;
-    }
-    case 'h':
-    {
-        static const uint8_t data[5] = {0x7F, 0x08, 0x04, 0x04, 0x78};
-        return data;
-    }
-    case 'i':
-    {
-        static const uint8_t data[5] = {0x00, 0x44, 0x7D, 0x40, 0x00};
-        return data;
-    }
-    case 'j':
-    {
-        static const uint8_t data[5] = {0x20, 0x40, 0x44, 0x3D, 0x00};
-        return data;
-    }
-    case 'k':
-    {
-        static const uint8_t data[5] = {0x7F, 0x10, 0x28, 0x44, 0x00};
-        return data;
-    }
-    case 'l':
-    {
-        static const uint8_t data[5] = {0x00, 0x41, 0x7F, 0x40, 0x00};
-        return data;
-    }
-    case 'm':
-    {
-        static const uint8_t data[5] = {0x7C, 0x04, 0x18, 0x04, 0x78};
-        return data;
-    }
-    case 'n':
-    {
-        static const uint8_t data[5] = {0x7C, 0x08, 0x04, 0x04, 0x78};
-        return data;
-    }
-    case 'o':
-    {
-        static const uint8_t data[5] = {0x38, 0x44, 0x44, 0x44, 0x38};
-        return data;
-    }
-    case 'p':
-    {
-        static const uint8_t data[5] = {0x7C, 0x14, 0x14, 0x14, 0x08};
-        return data;
-    }
-    case 'q':
-    {
-        static const uint8_t data[5] = {0x08, 0x14, 0x14, 0x18, 0x7C};
-        return data;
-    }
-    case 'r':
-    {
-        static const uint8_t data[5] = {0x7C, 0x08, 0x04, 0x04, 0x08};
-        return data;
-    }
-    case 's':
-    {
-        static const uint8_t data[5] = {0x48, 0x54, 0x54, 0x54, 0x20};
-        return data;
-    }
-    case 't':
-    {
-        static const uint8_t data[5] = {0x04, 0x3F, 0x44, 0x40, 0x20};
-        return data;
-    }
-    case 'u':
-    {
-        static const uint8_t data[5] = {0x3C, 0x40, 0x40, 0x20, 0x7C};
-        return data;
-    }
-    case 'v':
-    {
-        static const uint8_t data[5] = {0x1C, 0x20, 0x40, 0x20, 0x1C};
-        return data;
-    }
-    case 'w':
-    {
-        static const uint8_t data[5] = {0x3C, 0x40, 0x30, 0x40, 0x3C};
-        return data;
-    }
-    case 'x':
-    {
-        static const uint8_t data[5] = {0x44, 0x28, 0x10, 0x28, 0x44};
-        return data;
-    }
-    case 'y':
-    {
-        static const uint8_t data[5] = {0x0C, 0x50, 0x50, 0x50, 0x3C};
-        return data;
-    }
-    case 'z':
-    {
-        static const uint8_t data[5] = {0x44, 0x64, 0x54, 0x4C, 0x44};
-        return data;
-    }
-    // Chữ in hoa
-    case 'A':
-    {
-        static const uint8_t data[5] = {0x7E, 0x11, 0x11, 0x11, 0x7E};
-        return data;
-    }
-    case 'B':
-    {
-        static const uint8_t data[5] = {0x7F, 0x49, 0x49, 0x49, 0x36};
-        return data;
-    }
-    case 'C':
-    {
-        static const uint8_t data[5] = {0x3E, 0x41, 0x41, 0x41, 0x22};
-        return data;
-    }
-    case 'D':
-    {
-        static const uint8_t data[5] = {0x7F, 0x41, 0x41, 0x22, 0x1C};
-        return data;
-    }
-    case 'E':
-    {
-        static const uint8_t data[5] = {0x7F, 0x49, 0x49, 0x49, 0x41};
-        return data;
-    }
-    case 'F':
-    {
-        static const uint8_t data[5] = {0x7F, 0x09, 0x09, 0x09, 0x01};
-        return data;
-    }
-    case 'G':
-    {
-        static const uint8_t data[5] = {0x3E, 0x41, 0x49, 0x49, 0x7A};
-        return data;
-    }
-    case 'H':
-    {
-        static const uint8_t data[5] = {0x7F, 0x08, 0x08, 0x08, 0x7F};
-        return data;
-    }
-    case 'I':
-    {
-        static const uint8_t data[5] = {0x00, 0x41, 0x7F, 0x41, 0x00};
-        return data;
-    }
-    case 'J':
-    {
-        static const uint8_t data[5] = {0x20, 0x40, 0x41, 0x3F, 0x01};
-        return data;
-    }
-    case 'K':
-    {
-        static const uint8_t data[5] = {0x7F, 0x08, 0x14, 0x22, 0x41};
-        return data;
-    }
-    case 'L':
-    {
-        static const uint8_t data[5] = {0x7F, 0x40, 0x40, 0x40, 0x40};
-        return data;
-    }
-    case 'M':
-    {
-        static const uint8_t data[5] = {0x7F, 0x02, 0x0C, 0x02, 0x7F};
-        return data;
-    }
-    case 'N':
-    {
-        static const uint8_t data[5] = {0x7F, 0x04, 0x08, 0x10, 0x7F};
-        return data;
-    }
-    case 'O':
-    {
-        static const uint8_t data[5] = {0x3E, 0x41, 0x41, 0x41, 0x3E};
-        return data;
-    }
-    case 'P':
-    {
-        static const uint8_t data[5] = {0x7F, 0x09, 0x09, 0x09, 0x06};
-        return data;
-    }
-    case 'Q':
-    {
-        static const uint8_t data[5] = {0x3E, 0x41, 0x51, 0x21, 0x5E};
-        return data;
-    }
-    case 'R':
-    {
-        static const uint8_t data[5] = {0x7F, 0x09, 0x19, 0x29, 0x46};
-        return data;
-    }
-    case 'S':
-    {
-        static const uint8_t data[5] = {0x46, 0x49, 0x49, 0x49, 0x31};
-        return data;
-    }
-    case 'T':
-    {
-        static const uint8_t data[5] = {0x01, 0x01, 0x7F, 0x01, 0x01};
-        return data;
-    }
-    case 'U':
-    {
-        static const uint8_t data[5] = {0x3F, 0x40, 0x40, 0x40, 0x3F};
-        return data;
-    }
-    case 'V':
-    {
-        static const uint8_t data[5] = {0x1F, 0x20, 0x40, 0x20, 0x1F};
-        return data;
-    }
-    case 'W':
-    {
-        static const uint8_t data[5] = {0x7F, 0x20, 0x18, 0x20, 0x7F};
-        return data;
-    }
-    case 'X':
-    {
-        static const uint8_t data[5] = {0x63, 0x14, 0x08, 0x14, 0x63};
-        return data;
-    }
-    case 'Y':
-    {
-        static const uint8_t data[5] = {0x03, 0x04, 0x78, 0x04, 0x03};
-        return data;
-    }
-    case 'Z':
-    {
-        static const uint8_t data[5] = {0x61, 0x51, 0x49, 0x45, 0x43};
-        return data;
-    }
-    // Chữ số
-    case '0':
-    {
-        static const uint8_t data[5] = {0x3E, 0x51, 0x49, 0x45, 0x3E};
-        return data;
-    }
-    case '1':
-    {
-        static const uint8_t data[5] = {0x00, 0x42, 0x7F, 0x40, 0x00};
-        return data;
-    }
-    case '2':
-    {
-        static const uint8_t data[5] = {0x42, 0x61, 0x51, 0x49, 0x46};
-        return data;
-    }
-    case '3':
-    {
-        static const uint8_t data[5] = {0x21, 0x41, 0x45, 0x4B, 0x31};
-        return data;
-    }
-    case '4':
-    {
-        static const uint8_t data[5] = {0x18, 0x14, 0x12, 0x7F, 0x10};
-        return data;
-    }
-    case '5':
-    {
-        static const uint8_t data[5] = {0x27, 0x45, 0x45, 0x45, 0x39};
-        return data;
-    }
-    case '6':
-    {
-        static const uint8_t data[5] = {0x3C, 0x4A, 0x49, 0x49, 0x30};
-        return data;
-    }
-    case '7':
-    {
-        static const uint8_t data[5] = {0x01, 0x71, 0x09, 0x05, 0x03};
-        return data;
-    }
-    case '8':
-    {
-        static const uint8_t data[5] = {0x36, 0x49, 0x49, 0x49, 0x36};
-        return data;
-    }
-    case '9':
-    {
-        static const uint8_t data[5] = {0x06, 0x49, 0x49, 0x29, 0x1E};
-        return data;
-    }
-
-    // Dấu chấm câu
-    case ':':
-    {
-        static const uint8_t data[5] = {0x00, 0x36, 0x36, 0x00, 0x00};
-        return data;
-    }
-    case '.':
-    {
-        static const uint8_t data[5] = {0x00, 0x40, 0x60, 0x00, 0x00};
-        return data;
-    }
-
-    default:
-    {
-        static const uint8_t data[5] = {0x00, 0x00, 0x00, 0x00, 0x00};
-        return data;
-    }
-    }
-}
-
-/*=================== Vẽ ký tự và chuỗi ====================*/
-// Vẽ một ký tự tại vị trí (x, page). Mỗi ký tự có kích thước 5x7 pixel + 1 pixel khoảng cách.
-static void ssd1306_draw_char(uint8_t x, uint8_t page, char c)
-{
-    const uint8_t *bitmap = get_font_data(c);
-    for (int col = 0; col < 5; col++)
-    {
-        uint8_t line = bitmap[col];
-        for (int row = 0; row < 7; row++)
-        {
-            if (line & (1 << row))
-            {
-                uint16_t index = (page * OLED_WIDTH) + x + col;
-                if (index < OLED_BUFFER_SIZE)
-                    oled_buffer[index] |= (1 << row);
-            }
-        }
-    }
-    // Thêm 1 cột trắng làm khoảng cách sau ký tự
-    for (int row = 0; row < 7; row++)
-    {
-        uint16_t index = (page * OLED_WIDTH) + x + 5;
-        if (index < OLED_BUFFER_SIZE)
-            oled_buffer[index] &= ~(1 << row);
-    }
-}
-
-// Vẽ chuỗi ký tự bắt đầu từ vị trí (x, page)
-void oled_draw_string(uint8_t x, uint8_t page, const char *str)
-{
-    while (*str)
-    {
-        ssd1306_draw_char(x, page, *str);
-        x += 6; // 5 pixel cho ký tự + 1 pixel khoảng cách
-        str++;
-    }
-}
-
-/*=================== API Thư Viện ====================*/
-esp_err_t oled_init(void)
-{
-    esp_err_t err = i2c_master_init();
-    if (err != ESP_OK)
-    {
-        ESP_LOGE(TAG, "I2C init failed");
-        return err;
-    }
-    ssd1306_init();
-    oled_clear();
-    return ESP_OK;
-}
-
-void oled_clear(void)
-{
-    memset(oled_buffer, 0, OLED_BUFFER_SIZE);
-}
-
-esp_err_t oled_display(void)
-{
-    for (uint8_t page = 0; page < 8; page++)
-    {
-        ssd1306_send_command(0xB0 + page); // Set page address
-        ssd1306_send_command(0x00);        // Set lower column start address
-        ssd1306_send_command(0x10);        // Set higher column start address
-        // Gửi 128 byte dữ liệu cho mỗi trang
-        esp_err_t ret = ssd1306_send_data(&oled_buffer[OLED_WIDTH * page], OLED_WIDTH);
-        if (ret != ESP_OK)
-            return ret;
-    }
-    return ESP_OK;
-}
-
-// Hàm in thông tin dạng printf-like lên OLED
-void oled_print(uint8_t x, uint8_t page, const char *format, ...)
-{
-    char buffer[64];
-    va_list args;
-    va_start(args, format);
-    vsnprintf(buffer, sizeof(buffer), format, args);
-    va_end(args);
-
-    oled_draw_string(x, page, buffer);
-}
-// Hàm hỗ trợ: vẽ một pixel tại tọa độ (x, y)
-void oled_draw_pixel(uint8_t x, uint8_t y)
-{
-    if (x >= OLED_WIDTH || y >= OLED_HEIGHT)
-        return;
-    uint16_t page = y / 8;
-    uint8_t bit_position = y % 8;
-    uint16_t index = page * OLED_WIDTH + x;
-    if (index < OLED_BUFFER_SIZE)
-    {
-        oled_buffer[index] |= (1 << bit_position);
-    }
-}
-
-// Hàm hỗ trợ: vẽ một đường tròn (sử dụng thuật toán midpoint circle)
-void draw_circle(int cx, int cy, int r)
-{
-    int x = 0, y = r;
-    int d = 3 - 2 * r;
-    while (y >= x)
-    {
-        // Vẽ 8 điểm đối xứng quanh tâm
-        oled_draw_pixel(cx + x, cy + y);
-        oled_draw_pixel(cx - x, cy + y);
-        oled_draw_pixel(cx + x, cy - y);
-        oled_draw_pixel(cx - x, cy - y);
-        oled_draw_pixel(cx + y, cy + x);
-        oled_draw_pixel(cx - y, cy + x);
-        oled_draw_pixel(cx + y, cy - x);
-        oled_draw_pixel(cx - y, cy - x);
-        if (d > 0)
-        {
-            d = d + 4 * (x - y) + 10;
-            y--;
-        }
-        else
-        {
-            d = d + 4 * x + 6;
-        }
-        x++;
-    }
-}
-
-// Hàm vẽ con mắt mở (open eye): vẽ viền mắt và con tròn nhỏ làm con mắt (pupil)
-void draw_open_eye(void)
-{
-    oled_clear();
-    // Vẽ viền mắt: tâm (64, 32), bán kính 20 pixel
-    draw_circle(64, 32, 20);
-    // Vẽ pupil: tâm (64, 32), bán kính 5 pixel
-    draw_circle(64, 32, 5);
-    oled_display();
-}
-
-// Hàm vẽ con mắt chớp (blink): vẽ một đường ngang đại diện cho mí mắt
-void draw_closed_eye(void)
-{
-    oled_clear();
-    // Vẽ viền mắt (có thể bỏ qua nếu muốn chỉ hiển thị đường mí)
-    draw_circle(64, 32, 20);
-    // Vẽ mí mắt: vẽ đường ngang ở giữa mắt
-    for (int x = 44; x < 84; x++)
-    {
-        oled_draw_pixel(x, 32);
-    }
-    oled_display();
-}
-
-// Hàm animate mắt: hiệu ứng chớp mắt theo chu kỳ
-void oled_animate_eyes(void)
-{
-
-    // Hiển thị mắt mở
-    draw_open_eye();
-    vTaskDelay(500 / portTICK_PERIOD_MS);
-
-    // Hiển thị mắt chuyển dần sang chớp: có thể tạo thêm trạng thái bán chớp
-    draw_closed_eye();
-    vTaskDelay(200 / portTICK_PERIOD_MS);
-
-    // Hiển thị mắt hoàn toàn chớp
-    oled_clear();
-    for (int x = 44; x < 84; x++)
-    {
-        oled_draw_pixel(x, 32);
-    }
-    oled_display();
-    vTaskDelay(100 / portTICK_PERIOD_MS);
-
-    // Trở lại mắt mở
-    draw_open_eye();
-    vTaskDelay(500 / portTICK_PERIOD_MS);
-}
+#include "oled.h"
+#include "hal.h"
+#include "sysmon.h"
+#include "esp_log.h"
+#include "freertos/semphr.h"
+#include "freertos/event_groups.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+
+static const char *TAG = "OLED";
+
+// Bộ đệm vẽ (back buffer): các hàm vẽ chỉ ghi vào đây, không bao giờ chờ I2C
+static uint8_t oled_buffer[OLED_BUFFER_SIZE];
+
+// Khung đã submit đang chờ worker gửi (ready buffer), bảo vệ bởi oled_lock
+static uint8_t oled_ready[OLED_BUFFER_SIZE];
+
+// Bản sao nội dung đã gửi lên GDDRAM của SSD1306, chỉ worker truy cập
+static uint8_t oled_shadow[OLED_BUFFER_SIZE];
+static bool oled_shadow_valid = false;
+
+// Khung truyền tĩnh: mỗi cửa sổ gồm control byte 0x40 (data) và dữ liệu ngay sau nó
+static uint8_t oled_tx[OLED_BUFFER_SIZE + OLED_PAGES];
+
+// Một lần gửi: cửa sổ [c0..c1] x [p0..p1], dữ liệu tại oled_tx[offset] (kể cả byte 0x40)
+typedef struct
+{
+    uint8_t c0, c1, p0, p1;
+    uint16_t offset, len;
+} oled_window_t;
+
+// Chi phí ước tính (byte trên bus) cho mỗi lần đặt cửa sổ và mở giao dịch dữ liệu mới
+#define OLED_WINDOW_OVERHEAD 10
+
+// Đoạn cột bị thay đổi của mỗi trang: [lo, hi], trang sạch khi lo > hi
+typedef struct
+{
+    uint8_t lo[OLED_PAGES];
+    uint8_t hi[OLED_PAGES];
+} oled_dirty_t;
+
+static oled_dirty_t back_dirty;  // back buffer so với ready buffer, bảo vệ bởi dirty_lock
+static oled_dirty_t ready_dirty; // ready buffer so với màn hình, bảo vệ bởi oled_lock
+
+// Nhiều task cùng vẽ (display task, event loop, UDP task khi đóng socket): đánh dấu và
+// lấy-rồi-xóa back_dirty phải nguyên tử, nếu không dấu thay đổi của task này bị
+// oled_display() của task kia xóa mất. Critical section chỉ bao vài phép so sánh.
+static portMUX_TYPE dirty_lock = portMUX_INITIALIZER_UNLOCKED;
+
+// Worker I2C chạy nền
+#define OLED_IDLE_BIT BIT0
+static SemaphoreHandle_t oled_lock = NULL;
+static EventGroupHandle_t oled_events = NULL;
+static TaskHandle_t oled_worker = NULL;
+static oled_done_cb_t oled_done_cb = NULL;
+static void *oled_done_arg = NULL;
+
+// Thống kê lưu lượng I2C: frame_stats đếm khung đang gửi, oled_stats giữ kết quả (bảo vệ bởi oled_lock)
+static struct
+{
+    uint32_t transactions;
+    uint32_t bytes;
+} frame_stats;
+static oled_stats_t oled_stats;
+
+// Tăng mỗi lần oled_clear(), cho phép các lớp vẽ giữ trạng thái (widget) biết màn hình đã bị xóa
+static uint32_t oled_generation = 0;
+
+static inline void oled_dirty_mark(oled_dirty_t *d, uint8_t page, uint8_t x0, uint8_t x1)
+{
+    if (page >= OLED_PAGES || x0 >= OLED_WIDTH)
+        return;
+    if (x1 >= OLED_WIDTH)
+        x1 = OLED_WIDTH - 1;
+    if (x0 < d->lo[page])
+        d->lo[page] = x0;
+    if (x1 > d->hi[page])
+        d->hi[page] = x1;
+}
+
+static inline void oled_dirty_clean(oled_dirty_t *d, uint8_t page)
+{
+    d->lo[page] = OLED_WIDTH;
+    d->hi[page] = 0;
+}
+
+static inline bool oled_dirty_any(const oled_dirty_t *d)
+{
+    for (uint8_t page = 0; page < OLED_PAGES; page++)
+        if (d->lo[page] <= d->hi[page])
+            return true;
+    return false;
+}
+
+// Đánh dấu các cột [x0, x1] của một trang trong back buffer cần gửi lại.
+// Gọi sau khi đã ghi vào oled_buffer để oled_display() không chép dữ liệu cũ rồi xóa dấu.
+static inline void oled_mark_dirty(uint8_t page, uint8_t x0, uint8_t x1)
+{
+    portENTER_CRITICAL(&dirty_lock);
+    oled_dirty_mark(&back_dirty, page, x0, x1);
+    portEXIT_CRITICAL(&dirty_lock);
+}
+
+/*=================== I2C ===================*/
+// Một giao dịch I2C tới SSD1306; mọi lưu lượng tới màn hình đều đi qua đây để được đếm
+static esp_err_t oled_i2c_write(const uint8_t *data, size_t len)
+{
+    frame_stats.transactions++;
+    frame_stats.bytes += len;
+    return hal_i2c_write(OLED_ADDR, data, len, 1000);
+}
+
+/*=================== SSD1306 Driver ====================*/
+// Gửi lệnh cho SSD1306 (prefix 0x00)
+static esp_err_t ssd1306_send_command(uint8_t cmd)
+{
+    uint8_t data[2] = {0x00, cmd};
+    return oled_i2c_write(data, sizeof(data));
+}
+
+// Gửi một chuỗi lệnh trong cùng một giao dịch I2C (cmds[0] phải là control byte 0x00)
+static esp_err_t ssd1306_send_command_list(const uint8_t *cmds, size_t len)
+{
+    return oled_i2c_write(cmds, len);
+}
+
+// Gửi một cửa sổ đã đóng gói trong oled_tx: một giao dịch lệnh + một giao dịch dữ liệu
+static esp_err_t ssd1306_send_window(const oled_window_t *w)
+{
+    const uint8_t window[] = {0x00, 0x21, w->c0, w->c1, 0x22, w->p0, w->p1}; // Column/Page Address
+    esp_err_t err = ssd1306_send_command_list(window, sizeof(window));
+    if (err != ESP_OK)
+        return err;
+    err = oled_i2c_write(&oled_tx[w->offset], w->len);
+    if (err != ESP_OK)
+        return err;
+
+    // Màn hình giờ chứa đúng dữ liệu vừa gửi
+    size_t width = w->c1 - w->c0 + 1;
+    const uint8_t *src = &oled_tx[w->offset + 1];
+    for (uint8_t page = w->p0; page <= w->p1; page++)
+    {
+        memcpy(&oled_shadow[OLED_WIDTH * page + w->c0], src, width);
+        src += width;
+    }
+    return ESP_OK;
+}
+
+// Hàm khởi tạo SSD1306 (theo datasheet)
+static void ssd1306_init(void)
+{
+    vTaskDelay(100 / portTICK_PERIOD_MS);
+    ssd1306_send_command(0xAE); // Display OFF
+    ssd1306_send_command(0x20); // Set Memory Addressing Mode
+    ssd1306_send_command(0x00); // Horizontal Addressing Mode
+    ssd1306_send_command(0xB0); // Set Page Start Address cho Page Addressing Mode (0-7)
+    ssd1306_send_command(0xC8); // COM Output Scan Direction (remapped)
+    ssd1306_send_command(0x00); // Low Column Address
+    ssd1306_send_command(0x10); // High Column Address
+    ssd1306_send_command(0x40); // Start Line Address
+    ssd1306_send_command(0x81); // Set Contrast Control
+    ssd1306_send_command(0xFF);
+    ssd1306_send_command(0xA1); // Segment Re-map
+    ssd1306_send_command(0xA6); // Normal Display
+    ssd1306_send_command(0xA8); // Set Multiplex Ratio
+    ssd1306_send_command(0x3F);
+    ssd1306_send_command(0xA4); // Output follows RAM content
+    ssd1306_send_command(0xD3); // Set Display Offset
+    ssd1306_send_command(0x00);
+    ssd1306_send_command(0xD5); // Set Display Clock Divide Ratio/Oscillator Frequency
+    ssd1306_send_command(0xF0);
+    ssd1306_send_command(0xD9); // Set Pre-charge Period
+    ssd1306_send_command(0x22);
+    ssd1306_send_command(0xDA); // Set COM Pins Hardware Configuration
+    ssd1306_send_command(0x12);
+    ssd1306_send_command(0xDB); // Set VCOMH Deselect Level
+    ssd1306_send_command(0x20);
+    ssd1306_send_command(0x8D); // Charge Pump Setting
+    ssd1306_send_command(0x14); // Enable Charge Pump
+    ssd1306_send_command(0xAF); // Display ON
+}
+
+/*=================== Font 5x7 ====================*/
+// Bảng glyph 5x7 liền mạch cho ASCII in được (0x20..0x7E) và dấu độ ở vị trí 0x7F.
+// Mỗi glyph 5 byte, mỗi byte là một cột (bit 0 ở trên cùng).
+#define FONT_FIRST 0x20
+#define FONT_LAST OLED_GLYPH_DEGREE
+
+static const uint8_t font5x7[FONT_LAST - FONT_FIRST + 1][OLED_GLYPH_WIDTH] = {
+    {0x00, 0x00, 0x00, 0x00, 0x00}, // ' '
+    {0x00, 0x00, 0x5F, 0x00, 0x00}, // '!'
+    {0x00, 0x07, 0x00, 0x07, 0x00}, // '"'
+    {0x14, 0x7F, 0x14, 0x7F, 0x14}, // '#'
+    {0x24, 0x2A, 0x7F, 0x2A, 0x12}, // '$'
+    {0x23, 0x13, 0x08, 0x64, 0x62}, // '%'
+    {0x36, 0x49, 0x55, 0x22, 0x50}, // '&'
+    {0x00, 0x05, 0x03, 0x00, 0x00}, // '\''
+    {0x00, 0x1C, 0x22, 0x41, 0x00}, // '('
+    {0x00, 0x41, 0x22, 0x1C, 0x00}, // ')'
+    {0x14, 0x08, 0x3E, 0x08, 0x14}, // '*'
+    {0x08, 0x08, 0x3E, 0x08, 0x08}, // '+'
+    {0x00, 0x50, 0x30, 0x00, 0x00}, // ','
+    {0x08, 0x08, 0x08, 0x08, 0x08}, // '-'
+    {0x00, 0x40, 0x60, 0x00, 0x00}, // '.'
+    {0x20, 0x10, 0x08, 0x04, 0x02}, // '/'
+    {0x3E, 0x51, 0x49, 0x45, 0x3E}, // '0'
+    {0x00, 0x42, 0x7F, 0x40, 0x00}, // '1'
+    {0x42, 0x61, 0x51, 0x49, 0x46}, // '2'
+    {0x21, 0x41, 0x45, 0x4B, 0x31}, // '3'
+    {0x18, 0x14, 0x12, 0x7F, 0x10}, // '4'
+    {0x27, 0x45, 0x45, 0x45, 0x39}, // '5'
+    {0x3C, 0x4A, 0x49, 0x49, 0x30}, // '6'
+    {0x01, 0x71, 0x09, 0x05, 0x03}, // '7'
+    {0x36, 0x49, 0x49, 0x49, 0x36}, // '8'
+    {0x06, 0x49, 0x49, 0x29, 0x1E}, // '9'
+    {0x00, 0x36, 0x36, 0x00, 0x00}, // ':'
+    {0x00, 0x56, 0x36, 0x00, 0x00}, // ';'
+    {0x08, 0x14, 0x22, 0x41, 0x00}, // '<'
+    {0x14, 0x14, 0x14, 0x14, 0x14}, // '='
+    {0x00, 0x41, 0x22, 0x14, 0x08}, // '>'
+    {0x02, 0x01, 0x51, 0x09, 0x06}, // '?'
+    {0x32, 0x49, 0x79, 0x41, 0x3E}, // '@'
+    {0x7E, 0x11, 0x11, 0x11, 0x7E}, // 'A'
+    {0x7F, 0x49, 0x49, 0x49, 0x36}, // 'B'
+    {0x3E, 0x41, 0x41, 0x41, 0x22}, // 'C'
+    {0x7F, 0x41, 0x41, 0x22, 0x1C}, // 'D'
+    {0x7F, 0x49, 0x49, 0x49, 0x41}, // 'E'
+    {0x7F, 0x09, 0x09, 0x09, 0x01}, // 'F'
+    {0x3E, 0x41, 0x49, 0x49, 0x7A}, // 'G'
+    {0x7F, 0x08, 0x08, 0x08, 0x7F}, // 'H'
+    {0x00, 0x41, 0x7F, 0x41, 0x00}, // 'I'
+    {0x20, 0x40, 0x41, 0x3F, 0x01}, // 'J'
+    {0x7F, 0x08, 0x14, 0x22, 0x41}, // 'K'
+    {0x7F, 0x40, 0x40, 0x40, 0x40}, // 'L'
+    {0x7F, 0x02, 0x0C, 0x02, 0x7F}, // 'M'
+    {0x7F, 0x04, 0x08, 0x10, 0x7F}, // 'N'
+    {0x3E, 0x41, 0x41, 0x41, 0x3E}, // 'O'
+    {0x7F, 0x09, 0x09, 0x09, 0x06}, // 'P'
+    {0x3E, 0x41, 0x51, 0x21, 0x5E}, // 'Q'
+    {0x7F, 0x09, 0x19, 0x29, 0x46}, // 'R'
+    {0x46, 0x49, 0x49, 0x49, 0x31}, // 'S'
+    {0x01, 0x01, 0x7F, 0x01, 0x01}, // 'T'
+    {0x3F, 0x40, 0x40, 0x40, 0x3F}, // 'U'
+    {0x1F, 0x20, 0x40, 0x20, 0x1F}, // 'V'
+    {0x7F, 0x20, 0x18, 0x20, 0x7F}, // 'W'
+    {0x63, 0x14, 0x08, 0x14, 0x63}, // 'X'
+    {0x03, 0x04, 0x78, 0x04, 0x03}, // 'Y'
+    {0x61, 0x51, 0x49, 0x45, 0x43}, // 'Z'
+    {0x00, 0x7F, 0x41, 0x41, 0x00}, // '['
+    {0x02, 0x04, 0x08, 0x10, 0x20}, // '\\'
+    {0x00, 0x41, 0x41, 0x7F, 0x00}, // ']'
+    {0x04, 0x02, 0x01, 0x02, 0x04}, // '^'
+    {0x40, 0x40, 0x40, 0x40, 0x40}, // '_'
+    {0x00, 0x01, 0x02, 0x04, 0x00}, // '`'
+    {0x20, 0x54, 0x54, 0x54, 0x78}, // 'a'
+    {0x7F, 0x48, 0x44, 0x44, 0x38}, // 'b'
+    {0x38, 0x44, 0x44, 0x44, 0x20}, // 'c'
+    {0x38, 0x44, 0x44, 0x48, 0x7F}, // 'd'
+    {0x38, 0x54, 0x54, 0x54, 0x18}, // 'e'
+    {0x08, 0x7E, 0x09, 0x01, 0x02}, // 'f'
+    {0x0C, 0x52, 0x52, 0x52, 0x3E}, // 'g'
+    {0x7F, 0x08, 0x04, 0x04, 0x78}, // 'h'
+    {0x00, 0x44, 0x7D, 0x40, 0x00}, // 'i'
+    {0x20, 0x40, 0x44, 0x3D, 0x00}, // 'j'
+    {0x7F, 0x10, 0x28, 0x44, 0x00}, // 'k'
+    {0x00, 0x41, 0x7F, 0x40, 0x00}, // 'l'
+    {0x7C, 0x04, 0x18, 0x04, 0x78}, // 'm'
+    {0x7C, 0x08, 0x04, 0x04, 0x78}, // 'n'
+    {0x38, 0x44, 0x44, 0x44, 0x38}, // 'o'
+    {0x7C, 0x14, 0x14, 0x14, 0x08}, // 'p'
+    {0x08, 0x14, 0x14, 0x18, 0x7C}, // 'q'
+    {0x7C, 0x08, 0x04, 0x04, 0x08}, // 'r'
+    {0x48, 0x54, 0x54, 0x54, 0x20}, // 's'
+    {0x04, 0x3F, 0x44, 0x40, 0x20}, // 't'
+    {0x3C, 0x40, 0x40, 0x20, 0x7C}, // 'u'
+    {0x1C, 0x20, 0x40, 0x20, 0x1C}, // 'v'
+    {0x3C, 0x40, 0x30, 0x40, 0x3C}, // 'w'
+    {0x44, 0x28, 0x10, 0x28, 0x44}, // 'x'
+    {0x0C, 0x50, 0x50, 0x50, 0x3C}, // 'y'
+    {0x44, 0x64, 0x54, 0x4C, 0x44}, // 'z'
+    {0x00, 0x08, 0x36, 0x41, 0x00}, // '{'
+    {0x00, 0x00, 0x7F, 0x00, 0x00}, // '|'
+    {0x00, 0x41, 0x36, 0x08, 0x00}, // '}'
+    {0x10, 0x08, 0x08, 0x10, 0x08}, // '~'
+    {0x00, 0x06, 0x09, 0x09, 0x06}, // '°' (OLED_GLYPH_DEGREE)
+};
+
+// Chữ Latin/tiếng Việt có dấu không có glyph riêng: hiển thị bằng chữ cái gốc không dấu
+static char font_fallback(uint32_t cp)
+{
+    // U+00C0..U+00FF (Latin-1 Supplement)
+    static const char latin1[] = "AAAAAAACEEEEIIII"
+                                 "DNOOOOOxOUUUUYPs"
+                                 "aaaaaaaceeeeiiii"
+                                 "dnooooo/ouuuuypy";
+    if (cp >= 0xC0 && cp <= 0xFF)
+        return latin1[cp - 0xC0];
+
+    switch (cp)
+    {
+    case 0x0102: // Ă
+        return 'A';
+    case 0x0103: // ă
+        return 'a';
+    case 0x0110: // Đ
+        return 'D';
+    case 0x0111: // đ
+        return 'd';
+    case 0x0128: // Ĩ
+        return 'I';
+    case 0x0129: // ĩ
+        return 'i';
+    case 0x0168: // Ũ
+    case 0x01AF: // Ư
+        return 'U';
+    case 0x0169: // ũ
+    case 0x01B0: // ư
+        return 'u';
+    case 0x01A0: // Ơ
+        return 'O';
+    case 0x01A1: // ơ
+        return 'o';
+    default:
+        break;
+    }
+
+    // U+1EA0..U+1EF9 (Latin Extended Additional): hoa/thường xen kẽ, nhóm theo nguyên âm gốc
+    if (cp >= 0x1EA0 && cp <= 0x1EF9)
+    {
+        char base = cp < 0x1EB8 ? 'A' : cp < 0x1EC8 ? 'E' : cp < 0x1ECC ? 'I' : cp < 0x1EE4 ? 'O' : cp < 0x1EF2 ? 'U' : 'Y';
+        return (cp & 1) ? base - 'A' + 'a' : base;
+    }
+    return ' ';
+}
+
+// Trả về glyph cho một code point Unicode
+static const uint8_t *font_glyph(uint32_t cp)
+{
+    if (cp >= FONT_FIRST && cp <= FONT_LAST)
+        return font5x7[cp - FONT_FIRST];
+    if (cp == 0xB0) // °
+        return font5x7[OLED_GLYPH_DEGREE - FONT_FIRST];
+    return font5x7[font_fallback(cp) - FONT_FIRST];
+}
+
+// Đọc một code point UTF-8 và tiến con trỏ; byte lẻ không hợp lệ được trả về nguyên giá trị
+uint32_t oled_utf8_next(const char **str)
+{
+    const uint8_t *p = (const uint8_t *)*str;
+    uint32_t cp = *p++;
+    int extra = cp >= 0xF0 ? 3 : cp >= 0xE0 ? 2 : cp >= 0xC0 ? 1 : 0;
+    if (extra)
+    {
+        cp &= 0x3F >> extra;
+        while (extra-- && (*p & 0xC0) == 0x80)
+            cp = (cp << 6) | (*p++ & 0x3F);
+    }
+    *str = (const char *)p;
+    return cp;
+}
+
+/*=================== Vẽ ký tự và chuỗi ====================*/
+// Vẽ một glyph tại tọa độ pixel (x, y): 5 cột glyph được OR vào bộ đệm theo từng byte, cột thứ 6
+// (khoảng cách) bị xóa 7 bit như cũ. Khi y không chia hết cho 8, glyph vắt qua hai trang liền nhau.
+static void ssd1306_draw_glyph(uint8_t x, uint8_t y, const uint8_t *glyph)
+{
+    // Kiểm tra cắt (clip) một lần cho cả glyph
+    if (x >= OLED_WIDTH || y >= OLED_HEIGHT)
+        return;
+    uint8_t cols = (x + OLED_CHAR_WIDTH <= OLED_WIDTH) ? OLED_CHAR_WIDTH : OLED_WIDTH - x;
+    uint8_t page = y >> 3;
+    uint8_t shift = y & 7;
+    uint8_t *row = &oled_buffer[OLED_WIDTH * page + x];
+
+    if (shift == 0)
+    {
+        for (uint8_t col = 0; col < cols; col++)
+            row[col] = (col < OLED_GLYPH_WIDTH) ? row[col] | glyph[col] : row[col] & ~0x7F;
+        oled_mark_dirty(page, x, x + cols - 1);
+        return;
+    }
+
+    // Trang dưới có thể nằm ngoài màn hình: khi đó chỉ ghi phần trên
+    uint8_t *next = (page + 1 < OLED_PAGES) ? row + OLED_WIDTH : NULL;
+    const uint16_t space = 0x7F << shift;
+    for (uint8_t col = 0; col < cols; col++)
+    {
+        if (col < OLED_GLYPH_WIDTH)
+        {
+            uint16_t bits = glyph[col] << shift;
+            row[col] |= bits;
+            if (next)
+                next[col] |= bits >> 8;
+        }
+        else
+        {
+            row[col] &= ~space;
+            if (next)
+                next[col] &= ~(space >> 8);
+        }
+    }
+    oled_mark_dirty(page, x, x + cols - 1);
+    if (next)
+        oled_mark_dirty(page + 1, x, x + cols - 1);
+}
+
+// Vẽ chuỗi UTF-8 bắt đầu từ tọa độ pixel (x, y)
+void oled_draw_text(uint8_t x, uint8_t y, const char *str)
+{
+    int cx = x;
+    while (*str && cx < OLED_WIDTH)
+    {
+        ssd1306_draw_glyph(cx, y, font_glyph(oled_utf8_next(&str)));
+        cx += OLED_CHAR_WIDTH; // 5 pixel cho ký tự + 1 pixel khoảng cách
+    }
+}
+
+// Vẽ đè một ô ký tự tại (x, page): xóa nền 6 cột của ô rồi vẽ glyph
+void oled_draw_cell(uint8_t x, uint8_t page, uint32_t cp)
+{
+    oled_clear_cells(x, page, 1);
+    if (page < OLED_PAGES)
+        ssd1306_draw_glyph(x, page * 8, font_glyph(cp));
+}
+
+// Xóa count ô ký tự liên tiếp bắt đầu từ (x, page)
+void oled_clear_cells(uint8_t x, uint8_t page, uint8_t count)
+{
+    if (x >= OLED_WIDTH || page >= OLED_PAGES || count == 0)
+        return;
+    int width = count * OLED_CHAR_WIDTH;
+    if (x + width > OLED_WIDTH)
+        width = OLED_WIDTH - x;
+    memset(&oled_buffer[OLED_WIDTH * page + x], 0, width);
+    oled_mark_dirty(page, x, x + width - 1);
+}
+
+// Vẽ chuỗi ký tự bắt đầu từ vị trí (x, page)
+void oled_draw_string(uint8_t x, uint8_t page, const char *str)
+{
+    if (page < OLED_PAGES)
+        oled_draw_text(x, page * 8, str);
+}
+
+/*=================== API Thư Viện ====================*/
+// Đóng gói cửa sổ [c0..c1] x [p0..p1] của ready buffer vào oled_tx tại offset, theo thứ tự
+// Horizontal Addressing Mode (hết cột mới sang trang). Trả về offset kế tiếp.
+static uint16_t oled_pack_window(oled_window_t *w, uint8_t c0, uint8_t c1, uint8_t p0, uint8_t p1, uint16_t offset)
+{
+    size_t width = c1 - c0 + 1;
+    uint8_t *dst = &oled_tx[offset];
+    *dst++ = 0x40; // Data mode
+    for (uint8_t page = p0; page <= p1; page++)
+    {
+        memcpy(dst, &oled_ready[OLED_WIDTH * page + c0], width);
+        dst += width;
+    }
+    w->c0 = c0;
+    w->c1 = c1;
+    w->p0 = p0;
+    w->p1 = p1;
+    w->offset = offset;
+    w->len = dst - &oled_tx[offset];
+    return offset + w->len;
+}
+
+// Lấy các thay đổi của ready buffer so với màn hình và đóng gói vào oled_tx (gọi khi giữ oled_lock).
+// Trả về số cửa sổ cần gửi.
+static size_t oled_pack_windows(oled_window_t *windows)
+{
+    uint8_t lo[OLED_PAGES], hi[OLED_PAGES];
+    int c0 = OLED_WIDTH - 1, c1 = 0, p0 = -1, p1 = -1;
+    size_t span_bytes = 0, spans = 0;
+
+    for (uint8_t page = 0; page < OLED_PAGES; page++)
+    {
+        lo[page] = ready_dirty.lo[page];
+        hi[page] = ready_dirty.hi[page];
+        oled_dirty_clean(&ready_dirty, page);
+        if (lo[page] > hi[page])
+            continue;
+
+        // Thu hẹp đoạn thay đổi về các byte thực sự khác với màn hình
+        if (oled_shadow_valid)
+        {
+            const uint8_t *row = &oled_ready[OLED_WIDTH * page];
+            const uint8_t *shadow = &oled_shadow[OLED_WIDTH * page];
+            while (lo[page] <= hi[page] && row[lo[page]] == shadow[lo[page]])
+                lo[page]++;
+            while (hi[page] > lo[page] && row[hi[page]] == shadow[hi[page]])
+                hi[page]--;
+            if (lo[page] > hi[page])
+                continue;
+        }
+
+        if (lo[page] < c0)
+            c0 = lo[page];
+        if (hi[page] > c1)
+            c1 = hi[page];
+        if (p0 < 0)
+            p0 = page;
+        p1 = page;
+        span_bytes += hi[page] - lo[page] + 1;
+        spans++;
+    }
+    if (spans == 0)
+        return 0;
+
+    // Gửi cả khung chữ nhật bao quanh nếu không tốn hơn gửi từng đoạn
+    size_t window_bytes = (size_t)(c1 - c0 + 1) * (p1 - p0 + 1);
+    if (window_bytes <= span_bytes + (spans - 1) * OLED_WINDOW_OVERHEAD)
+    {
+        oled_pack_window(&windows[0], c0, c1, p0, p1, 0);
+        return 1;
+    }
+
+    size_t count = 0;
+    uint16_t offset = 0;
+    for (uint8_t page = p0; page <= p1; page++)
+    {
+        if (lo[page] <= hi[page])
+            offset = oled_pack_window(&windows[count++], lo[page], hi[page], page, page, offset);
+    }
+    return count;
+}
+
+// Worker I2C: gửi ready buffer lên màn hình mỗi khi có submit mới
+static void oled_worker_task(void *pvParameters)
+{
+    oled_window_t windows[OLED_PAGES];
+
+    while (1)
+    {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+
+        xSemaphoreTake(oled_lock, portMAX_DELAY);
+        size_t count = oled_pack_windows(windows);
+        xSemaphoreGive(oled_lock);
+
+        esp_err_t ret = ESP_OK;
+        size_t sent = 0;
+        frame_stats.transactions = 0;
+        frame_stats.bytes = 0;
+        while (sent < count && (ret = ssd1306_send_window(&windows[sent])) == ESP_OK)
+            sent++;
+
+        xSemaphoreTake(oled_lock, portMAX_DELAY);
+        if (ret != ESP_OK)
+        {
+            // Trả các cửa sổ chưa gửi được về ready để lần submit sau gửi lại
+            for (size_t i = sent; i < count; i++)
+                for (uint8_t page = windows[i].p0; page <= windows[i].p1; page++)
+                    oled_dirty_mark(&ready_dirty, page, windows[i].c0, windows[i].c1);
+        }
+        else if (count > 0)
+        {
+            oled_shadow_valid = true;
+        }
+        if (count > 0)
+        {
+            oled_stats.frames++;
+            oled_stats.last_transactions = frame_stats.transactions;
+            oled_stats.last_bytes = frame_stats.bytes;
+            oled_stats.total_bytes += frame_stats.bytes;
+            if (ret != ESP_OK)
+                oled_stats.errors++;
+        }
+        // Đặt bit idle trong cùng khóa với lần kiểm tra: oled_display() xóa bit dưới khóa này,
+        // nên oled_wait_idle() không thể trả về khi còn một submit mới chưa gửi
+        if (!oled_dirty_any(&ready_dirty))
+            xEventGroupSetBits(oled_events, OLED_IDLE_BIT);
+        xSemaphoreGive(oled_lock);
+
+        if (ret != ESP_OK)
+            ESP_LOGW(TAG, "Flush failed: %s", esp_err_to_name(ret));
+        if (oled_done_cb)
+            oled_done_cb(ret, oled_done_arg);
+    }
+}
+
+SYSMON_MUTEX_STORAGE(oled);
+SYSMON_EVENT_GROUP_STORAGE(oled);
+SYSMON_TASK_STORAGE(oled_io, TASK_OLED_IO_STACK);
+
+esp_err_t oled_init(void)
+{
+    esp_err_t err = hal_i2c_init(I2C_MASTER_SDA_IO, I2C_MASTER_SCL_IO, I2C_MASTER_FREQ_HZ);
+    if (err != ESP_OK)
+    {
+        ESP_LOGE(TAG, "I2C init failed");
+        return err;
+    }
+    ssd1306_init();
+
+    portENTER_CRITICAL(&dirty_lock);
+    for (uint8_t page = 0; page < OLED_PAGES; page++)
+        oled_dirty_clean(&back_dirty, page);
+    portEXIT_CRITICAL(&dirty_lock);
+    for (uint8_t page = 0; page < OLED_PAGES; page++)
+        oled_dirty_clean(&ready_dirty, page);
+    oled_clear();
+
+    // GDDRAM sau khi khởi động chứa dữ liệu rác: lần display đầu gửi toàn bộ khung
+    oled_shadow_valid = false;
+    for (uint8_t page = 0; page < OLED_PAGES; page++)
+        oled_mark_dirty(page, 0, OLED_WIDTH - 1);
+
+    if (oled_worker == NULL)
+    {
+        oled_lock = SYSMON_MUTEX_CREATE(oled);
+        oled_events = SYSMON_EVENT_GROUP_CREATE(oled);
+        if (oled_lock == NULL || oled_events == NULL)
+            return ESP_ERR_NO_MEM;
+        xEventGroupSetBits(oled_events, OLED_IDLE_BIT);
+        if (SYSMON_TASK_CREATE(oled_io, oled_worker_task, "oled_io", NULL, TASK_OLED_IO_PRIO, TASK_OLED_IO_CORE, &oled_worker) == NULL)
+            return ESP_ERR_NO_MEM;
+    }
+    return ESP_OK;
+}
+
+// Xóa bộ đệm; chỉ những đoạn đang có điểm sáng mới bị đánh dấu thay đổi
+void oled_clear(void)
+{
+    for (uint8_t page = 0; page < OLED_PAGES; page++)
+    {
+        uint8_t *row = &oled_buffer[OLED_WIDTH * page];
+        int lo = 0, hi = OLED_WIDTH - 1;
+        while (lo <= hi && row[lo] == 0)
+            lo++;
+        while (hi > lo && row[hi] == 0)
+            hi--;
+        memset(row, 0, OLED_WIDTH);
+        if (lo <= hi)
+            oled_mark_dirty(page, lo, hi);
+    }
+    oled_generation++;
+}
+
+uint32_t oled_get_generation(void)
+{
+    return oled_generation;
+}
+
+// Submit khung hiện tại: chép các đoạn thay đổi sang ready buffer, đánh thức worker và trả về ngay
+esp_err_t oled_display(void)
+{
+    if (oled_worker == NULL)
+        return ESP_ERR_INVALID_STATE;
+
+    xSemaphoreTake(oled_lock, portMAX_DELAY);
+    for (uint8_t page = 0; page < OLED_PAGES; page++)
+    {
+        // Lấy và xóa dấu trước khi chép: nét vẽ đến sau đó sẽ đánh dấu lại cho lần submit kế
+        portENTER_CRITICAL(&dirty_lock);
+        uint8_t lo = back_dirty.lo[page], hi = back_dirty.hi[page];
+        oled_dirty_clean(&back_dirty, page);
+        portEXIT_CRITICAL(&dirty_lock);
+        if (lo > hi)
+            continue;
+        memcpy(&oled_ready[OLED_WIDTH * page + lo], &oled_buffer[OLED_WIDTH * page + lo], hi - lo + 1);
+        oled_dirty_mark(&ready_dirty, page, lo, hi);
+    }
+    xEventGroupClearBits(oled_events, OLED_IDLE_BIT);
+    xSemaphoreGive(oled_lock);
+
+    xTaskNotifyGive(oled_worker);
+    return ESP_OK;
+}
+
+void oled_get_stats(oled_stats_t *out)
+{
+    if (oled_lock == NULL)
+    {
+        memset(out, 0, sizeof(*out));
+        return;
+    }
+    xSemaphoreTake(oled_lock, portMAX_DELAY);
+    *out = oled_stats;
+    xSemaphoreGive(oled_lock);
+}
+
+void oled_set_done_callback(oled_done_cb_t cb, void *arg)
+{
+    oled_done_arg = arg;
+    oled_done_cb = cb;
+}
+
+esp_err_t oled_wait_idle(uint32_t timeout_ms)
+{
+    if (oled_events == NULL)
+        return ESP_ERR_INVALID_STATE;
+    EventBits_t bits = xEventGroupWaitBits(oled_events, OLED_IDLE_BIT, pdFALSE, pdTRUE, pdMS_TO_TICKS(timeout_ms));
+    return (bits & OLED_IDLE_BIT) ? ESP_OK : ESP_ERR_TIMEOUT;
+}
+
+// Hàm in thông tin dạng printf-like lên OLED
+void oled_print(uint8_t x, uint8_t page, const char *format, ...)
+{
+    char buffer[64];
+    va_list args;
+    va_start(args, format);
+    vsnprintf(buffer, sizeof(buffer), format, args);
+    va_end(args);
+
+    oled_draw_string(x, page, buffer);
+}
+// Hàm hỗ trợ: vẽ một pixel tại tọa độ (x, y)
+void oled_draw_pixel(uint8_t x, uint8_t y)
+{
+    if (x >= OLED_WIDTH || y >= OLED_HEIGHT)
+        return;
+    uint16_t page = y / 8;
+    uint8_t bit_position = y % 8;
+    uint16_t index = page * OLED_WIDTH + x;
+    if (index < OLED_BUFFER_SIZE)
+    {
+        oled_buffer[index] |= (1 << bit_position);
+        oled_mark_dirty(page, x, x);
+    }
+}
+
+// Hàm hỗ trợ: vẽ một đường tròn (sử dụng thuật toán midpoint circle)
+void draw_circle(int cx, int cy, int r)
+{
+    int x = 0, y = r;
+    int d = 3 - 2 * r;
+    while (y >= x)
+    {
+        // Vẽ 8 điểm đối xứng quanh tâm
+        oled_draw_pixel(cx + x, cy + y);
+        oled_draw_pixel(cx - x, cy + y);
+        oled_draw_pixel(cx + x, cy - y);
+        oled_draw_pixel(cx - x, cy - y);
+        oled_draw_pixel(cx + y, cy + x);
+        oled_draw_pixel(cx - y, cy + x);
+        oled_draw_pixel(cx + y, cy - x);
+        oled_draw_pixel(cx - y, cy - x);
+        if (d > 0)
+        {
+            d = d + 4 * (x - y) + 10;
+            y--;
+        }
+        else
+        {
+            d = d + 4 * x + 6;
+        }
+        x++;
+    }
+}
+
+// Hàm vẽ con mắt mở (open eye): vẽ viền mắt và con tròn nhỏ làm con mắt (pupil)
+void draw_open_eye(void)
+{
+    oled_clear();
+    // Vẽ viền mắt: tâm (64, 32), bán kính 20 pixel
+    draw_circle(64, 32, 20);
+    // Vẽ pupil: tâm (64, 32), bán kính 5 pixel
+    draw_circle(64, 32, 5);
+    oled_display();
+}
+
+// Hàm vẽ con mắt chớp (blink): vẽ một đường ngang đại diện cho mí mắt
+void draw_closed_eye(void)
+{
+    oled_clear();
+    // Vẽ viền mắt (có thể bỏ qua nếu muốn chỉ hiển thị đường mí)
+    draw_circle(64, 32, 20);
+    // Vẽ mí mắt: vẽ đường ngang ở giữa mắt
+    for (int x = 44; x < 84; x++)
+    {
+        oled_draw_pixel(x, 32);
+    }
+    oled_display();
+}
+
+// Hàm animate mắt: hiệu ứng chớp mắt theo chu kỳ
+void oled_animate_eyes(void)
+{
+
+    // Hiển thị mắt mở
+    draw_open_eye();
+    vTaskDelay(500 / portTICK_PERIOD_MS);
+
+    // Hiển thị mắt chuyển dần sang chớp: có thể tạo thêm trạng thái bán chớp
+    draw_closed_eye();
+    vTaskDelay(200 / portTICK_PERIOD_MS);
+
+    // Hiển thị mắt hoàn toàn chớp
+    oled_clear();
+    for (int x = 44; x < 84; x++)
+    {
+        oled_draw_pixel(x, 32);
+    }
+    oled_display();
+    vTaskDelay(100 / portTICK_PERIOD_MS);
+
+    // Trở lại mắt mở
+    draw_open_eye();
+    vTaskDelay(500 / portTICK_PERIOD_MS);
+}
@@ -1,79 +1,181 @@
-#ifndef OLED_H
-#define OLED_H
-
-#include "driver/i2c.h"
-#include "freertos/FreeRTOS.h"
-#include "freertos/task.h"
-#include "esp_err.h"
-#include <stdarg.h>
-#include "qrcode.h"
-
-// Cấu hình I2C & OLED
-#define I2C_MASTER_NUM       I2C_NUM_0
-#define I2C_MASTER_SCL_IO    22
-#define I2C_MASTER_SDA_IO    21
-#define I2C_MASTER_FREQ_HZ   400000
-#define OLED_ADDR            0x3C
-
-#define OLED_WIDTH           128
-#define OLED_HEIGHT          64
-#define OLED_BUFFER_SIZE     (OLED_WIDTH * OLED_HEIGHT / 8)
-
-#ifdef __cplusplus
-extern "C"
-{
-#endif
-
-    /**
-     * @brief Khởi tạo giao tiếp I2C và OLED.
-     *
-     * @return esp_err_t kết quả khởi tạo.
-     */
-    esp_err_t oled_init(void);
-
-    /**
-     * @brief Xóa bộ đệm hiển thị.
-     */
-    void oled_clear(void);
-
-    /**
-     * @brief Cập nhật nội dung bộ đệm lên màn hình OLED.
-     *
-     * @return esp_err_t kết quả cập nhật.
-     */
-    esp_err_t oled_display(void);
-
-    /**
-     * @brief Vẽ một chuỗi ký tự tại vị trí (x, page) trên bộ đệm.
-     *
-     * @param x Vị trí cột bắt đầu (0 -> OLED_WIDTH-1).
-     * @param page Vị trí trang (mỗi trang có 8 pixel cao).
-     * @param str Chuỗi cần hiển thị.
-     */
-    void oled_draw_string(uint8_t x, uint8_t page, const char *str);
-
-    /**
-     * @brief Hàm in thông tin định dạng (printf-like) lên OLED.
-     *
-     * @param x Vị trí cột bắt đầu.
-     * @param page Vị trí trang.
-     * @param format Chuỗi định dạng.
-     * @param ... Tham số cho chuỗi định dạng.
-     */
-    void oled_print(uint8_t x, uint8_t page, const char *format, ...);
-
-    /**
-     * @brief Hàm animate mắt, tạo hiệu ứng con mắt đẹp (mở, chớp, v.v...).
-     */
-    void oled_animate_eyes(void);
-
-    /**
-     * @brief Hàm tạo QR code (nếu cần sử dụng).
-     */
-    void generate_qr_code(void);
-
-#ifdef __cplusplus
-}
-#endif
-
-#endif // OLED_H
+#ifndef OLED_H
+#define OLED_H
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_err.h"
+#include <stdarg.h>
+
+// Cấu hình I2C & OLED
+#define I2C_MASTER_SCL_IO    22
+#define I2C_MASTER_SDA_IO    21
+#define I2C_MASTER_FREQ_HZ   400000
+#define OLED_ADDR            0x3C
+
+#define OLED_WIDTH           128
+#define OLED_HEIGHT          64
+#define OLED_PAGES           (OLED_HEIGHT / 8)
+#define OLED_BUFFER_SIZE     (OLED_WIDTH * OLED_HEIGHT / 8)
+
+// Font 5x7: mỗi ký tự chiếm 5 cột glyph + 1 cột khoảng cách
+#define OLED_GLYPH_WIDTH     5
+#define OLED_CHAR_WIDTH      6
+#define OLED_GLYPH_DEGREE    0x7F // Glyph dấu độ; "°" trong chuỗi UTF-8 cũng được hiển thị
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+    /**
+     * @brief Callback báo một lần gửi khung lên màn hình đã xong (gọi từ worker I2C).
+     *
+     * @param result ESP_OK nếu gửi thành công.
+     * @param arg Tham số truyền vào oled_set_done_callback.
+     */
+    typedef void (*oled_done_cb_t)(esp_err_t result, void *arg);
+
+    /**
+     * @brief Thống kê lưu lượng I2C của worker hiển thị.
+     */
+    typedef struct
+    {
+        uint32_t frames;            // Số lần flush có dữ liệu thay đổi
+        uint32_t last_transactions; // Số giao dịch I2C của lần flush gần nhất
+        uint32_t last_bytes;        // Số byte I2C của lần flush gần nhất
+        uint32_t total_bytes;       // Tổng số byte I2C đã gửi qua các lần flush
+        uint32_t errors;            // Số lần flush bị lỗi
+    } oled_stats_t;
+
+    /**
+     * @brief Khởi tạo giao tiếp I2C và OLED.
+     *
+     * @return esp_err_t kết quả khởi tạo.
+     */
+    esp_err_t oled_init(void);
+
+    /**
+     * @brief Xóa bộ đệm hiển thị.
+     */
+    void oled_clear(void);
+
+    /**
+     * @brief Submit nội dung bộ đệm để cập nhật lên màn hình OLED.
+     *
+     * Không chờ I2C: các đoạn đã thay đổi được chép sang bộ đệm chờ gửi và
+     * worker nền sẽ gửi chúng đi (chỉ những byte khác với màn hình). Có thể
+     * vẽ tiếp khung sau ngay trong lúc khung trước đang được truyền.
+     *
+     * @return ESP_OK, hoặc ESP_ERR_INVALID_STATE nếu chưa gọi oled_init.
+     */
+    esp_err_t oled_display(void);
+
+    /**
+     * @brief Đăng ký callback được gọi sau mỗi lần worker gửi xong một khung.
+     *
+     * @param cb Hàm callback (NULL để hủy).
+     * @param arg Tham số truyền cho callback.
+     */
+    void oled_set_done_callback(oled_done_cb_t cb, void *arg);
+
+    /**
+     * @brief Lấy thống kê lưu lượng I2C của các lần flush.
+     *
+     * @param out Nơi nhận thống kê.
+     */
+    void oled_get_stats(oled_stats_t *out);
+
+    /**
+     * @brief Chờ đến khi mọi khung đã submit được gửi xong.
+     *
+     * @param timeout_ms Thời gian chờ tối đa (ms).
+     * @return ESP_OK hoặc ESP_ERR_TIMEOUT.
+     */
+    esp_err_t oled_wait_idle(uint32_t timeout_ms);
+
+    /**
+     * @brief Vẽ một chuỗi ký tự tại vị trí (x, page) trên bộ đệm.
+     *
+     * @param x Vị trí cột bắt đầu (0 -> OLED_WIDTH-1).
+     * @param page Vị trí trang (mỗi trang có 8 pixel cao).
+     * @param str Chuỗi cần hiển thị.
+     */
+    void oled_draw_string(uint8_t x, uint8_t page, const char *str);
+
+    /**
+     * @brief Vẽ một chuỗi UTF-8 tại tọa độ pixel (x, y) trên bộ đệm.
+     *
+     * y không cần chia hết cho 8 (ký tự có thể vắt qua hai trang). Chữ có dấu
+     * tiếng Việt được hiển thị bằng chữ cái gốc không dấu.
+     *
+     * @param x Vị trí cột bắt đầu (0 -> OLED_WIDTH-1).
+     * @param y Vị trí hàng pixel của đỉnh ký tự (0 -> OLED_HEIGHT-1).
+     * @param str Chuỗi cần hiển thị.
+     */
+    void oled_draw_text(uint8_t x, uint8_t y, const char *str);
+
+    /**
+     * @brief Vẽ đè một ô ký tự (6 cột) tại (x, page): xóa nền ô rồi vẽ glyph.
+     *
+     * @param x Vị trí cột bắt đầu của ô.
+     * @param page Vị trí trang.
+     * @param cp Code point Unicode của ký tự.
+     */
+    void oled_draw_cell(uint8_t x, uint8_t page, uint32_t cp);
+
+    /**
+     * @brief Xóa count ô ký tự liên tiếp bắt đầu từ (x, page).
+     */
+    void oled_clear_cells(uint8_t x, uint8_t page, uint8_t count);
+
+    /**
+     * @brief Đọc một code point từ chuỗi UTF-8 và tiến con trỏ qua nó.
+     *
+     * @param str Con trỏ tới con trỏ chuỗi (không được trỏ vào ký tự kết thúc).
+     * @return uint32_t code point đã đọc.
+     */
+    uint32_t oled_utf8_next(const char **str);
+
+    /**
+     * @brief Số lần bộ đệm đã bị xóa bằng oled_clear().
+     *
+     * Lớp vẽ giữ trạng thái (ví dụ oled_widget) dùng giá trị này để biết khi
+     * nào nội dung đã vẽ trước đó không còn trên bộ đệm.
+     */
+    uint32_t oled_get_generation(void);
+
+    /**
+     * @brief Hàm in thông tin định dạng (printf-like) lên OLED.
+     *
+     * @param x Vị trí cột bắt đầu.
+     * @param page Vị trí trang.
+     * @param format Chuỗi định dạng.
+     * @param ... Tham số cho chuỗi định dạng.
+     */
+    void oled_print(uint8_t x, uint8_t page, const char *format, ...);
+
+    /**
+     * @brief Vẽ một pixel tại tọa độ (x, y) trên bộ đệm (bỏ qua nếu ngoài màn hình).
+     */
+    void oled_draw_pixel(uint8_t x, uint8_t y);
+
+    /**
+     * @brief Vẽ đường tròn tâm (cx, cy), bán kính r (thuật toán midpoint circle).
+     */
+    void draw_circle(int cx, int cy, int r);
+
+    /**
+     * @brief Hàm animate mắt, tạo hiệu ứng con mắt đẹp (mở, chớp, v.v...).
+     */
+    void oled_animate_eyes(void);
+
+    /**
+     * @brief Hàm tạo QR code (nếu cần sử dụng).
+     */
+    void generate_qr_code(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // OLED_H
@@ -0,0 +1,93 @@
+#include "oled_widget.h"
+#include <stdio.h>
+#include <string.h>
+#include <stdarg.h>
+
+// Trạng thái giữ lại của một slot văn bản
+typedef struct
+{
+    bool bound;
+    uint8_t x;
+    uint8_t page;
+    uint8_t max_chars;
+    uint8_t len;                            // Số ô đang hiển thị
+    uint32_t cells[OLED_WIDGET_MAX_CHARS];  // Code point của từng ô đang hiển thị
+    uint32_t generation;                    // oled_get_generation() lúc vẽ gần nhất
+    bool valid;                             // false: lần cập nhật sau vẽ lại toàn bộ
+} oled_widget_t;
+
+static oled_widget_t widgets[OLED_WIDGET_MAX_SLOTS];
+
+esp_err_t oled_widget_bind(uint8_t slot, uint8_t x, uint8_t page, uint8_t max_chars)
+{
+    if (slot >= OLED_WIDGET_MAX_SLOTS || x >= OLED_WIDTH || page >= OLED_PAGES)
+        return ESP_ERR_INVALID_ARG;
+
+    uint8_t fit = (OLED_WIDTH - x) / OLED_CHAR_WIDTH;
+    oled_widget_t *w = &widgets[slot];
+    w->bound = true;
+    w->x = x;
+    w->page = page;
+    w->max_chars = max_chars < fit ? max_chars : fit;
+    w->len = 0;
+    w->valid = false;
+    return ESP_OK;
+}
+
+void oled_widget_set(uint8_t slot, const char *text)
+{
+    if (slot >= OLED_WIDGET_MAX_SLOTS || !widgets[slot].bound)
+        return;
+    oled_widget_t *w = &widgets[slot];
+
+    // Bộ đệm đã bị oled_clear(): vùng của slot đang trống. Slot bị invalidate: tự xóa vùng của nó
+    uint32_t generation = oled_get_generation();
+    if (w->generation != generation)
+    {
+        w->len = 0;
+        w->generation = generation;
+        w->valid = true;
+    }
+    else if (!w->valid)
+    {
+        oled_clear_cells(w->x, w->page, w->max_chars);
+        w->len = 0;
+        w->valid = true;
+    }
+
+    uint8_t n = 0;
+    while (*text && n < w->max_chars)
+    {
+        uint32_t cp = oled_utf8_next(&text);
+        if (n >= w->len || w->cells[n] != cp)
+        {
+            // Ô mới sau vùng trống chỉ cần vẽ nếu không phải khoảng trắng
+            if (n < w->len || cp != ' ')
+                oled_draw_cell(w->x + n * OLED_CHAR_WIDTH, w->page, cp);
+            w->cells[n] = cp;
+        }
+        n++;
+    }
+
+    // Xóa các ô thừa của chuỗi cũ dài hơn
+    if (n < w->len)
+        oled_clear_cells(w->x + n * OLED_CHAR_WIDTH, w->page, w->len - n);
+    w->len = n;
+}
+
+void oled_widget_printf(uint8_t slot, const char *format, ...)
+{
+    char buffer[64];
+    va_list args;
+    va_start(args, format);
+    vsnprintf(buffer, sizeof(buffer), format, args);
+    va_end(args);
+
+    oled_widget_set(slot, buffer);
+}
+
+void oled_widget_invalidate(void)
+{
+    for (uint8_t slot = 0; slot < OLED_WIDGET_MAX_SLOTS; slot++)
+        widgets[slot].valid = false;
+}
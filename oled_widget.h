@@ -0,0 +1,50 @@
+#ifndef OLED_WIDGET_H
+#define OLED_WIDGET_H
+
+#include "oled.h"
+
+#define OLED_WIDGET_MAX_SLOTS 8
+#define OLED_WIDGET_MAX_CHARS (OLED_WIDTH / OLED_CHAR_WIDTH)
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+    /**
+     * @brief Gắn một slot văn bản cố định vào vị trí (x, page) trên màn hình.
+     *
+     * Slot nhớ chuỗi đã vẽ lần trước; các lần cập nhật sau chỉ vẽ lại những ô
+     * ký tự khác nhau và xóa các ô thừa ở cuối.
+     *
+     * @param slot Chỉ số slot (0 -> OLED_WIDGET_MAX_SLOTS-1).
+     * @param x Vị trí cột bắt đầu.
+     * @param page Vị trí trang.
+     * @param max_chars Số ký tự tối đa của slot (bị giới hạn bởi mép phải màn hình).
+     * @return ESP_OK hoặc ESP_ERR_INVALID_ARG.
+     */
+    esp_err_t oled_widget_bind(uint8_t slot, uint8_t x, uint8_t page, uint8_t max_chars);
+
+    /**
+     * @brief Cập nhật nội dung của slot.
+     *
+     * @param slot Chỉ số slot đã gắn.
+     * @param text Chuỗi UTF-8 mới.
+     */
+    void oled_widget_set(uint8_t slot, const char *text);
+
+    /**
+     * @brief Cập nhật nội dung của slot theo định dạng printf-like.
+     */
+    void oled_widget_printf(uint8_t slot, const char *format, ...);
+
+    /**
+     * @brief Buộc mọi slot vẽ lại toàn bộ ở lần cập nhật tiếp theo.
+     */
+    void oled_widget_invalidate(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // OLED_WIDGET_H
@@ -0,0 +1,235 @@
+#include "ssd1306_sim.h"
+#include <stdio.h>
+#include <string.h>
+
+#define SIM_WIDTH 128
+#define SIM_PAGES 8
+#define SIM_HEIGHT (SIM_PAGES * 8)
+
+// Chế độ địa chỉ bộ nhớ (lệnh 0x20)
+enum
+{
+    SIM_ADDR_HORIZONTAL = 0,
+    SIM_ADDR_VERTICAL = 1,
+    SIM_ADDR_PAGE = 2,
+};
+
+static struct
+{
+    uint8_t gddram[SIM_PAGES][SIM_WIDTH];
+    uint8_t mode;
+    uint8_t col_start, col_end, page_start, page_end;
+    uint8_t col, page;
+    bool seg_remap, com_remap, inverted, display_on;
+
+    // Lệnh đang chờ tham số
+    uint8_t cmd;
+    uint8_t params[6];
+    uint8_t param_count, param_needed;
+
+    ssd1306_sim_counters_t counters;
+} sim;
+
+// Số byte tham số theo sau mỗi lệnh
+static uint8_t sim_param_count(uint8_t cmd)
+{
+    switch (cmd)
+    {
+    case 0x20: // Memory Addressing Mode
+    case 0x81: // Contrast
+    case 0x8D: // Charge Pump
+    case 0xA8: // Multiplex Ratio
+    case 0xD3: // Display Offset
+    case 0xD5: // Clock Divide
+    case 0xD9: // Pre-charge
+    case 0xDA: // COM Pins
+    case 0xDB: // VCOMH
+        return 1;
+    case 0x21: // Column Address
+    case 0x22: // Page Address
+    case 0xA3: // Vertical Scroll Area
+        return 2;
+    case 0x29: // Vertical + Horizontal Scroll
+    case 0x2A:
+        return 5;
+    case 0x26: // Horizontal Scroll
+    case 0x27:
+        return 6;
+    default:
+        return 0;
+    }
+}
+
+static void sim_execute(uint8_t cmd, const uint8_t *p)
+{
+    switch (cmd)
+    {
+    case 0x20:
+        sim.mode = p[0] & 0x03;
+        break;
+    case 0x21:
+        sim.col_start = sim.col = p[0] & 0x7F;
+        sim.col_end = p[1] & 0x7F;
+        break;
+    case 0x22:
+        sim.page_start = sim.page = p[0] & 0x07;
+        sim.page_end = p[1] & 0x07;
+        break;
+    case 0xA0:
+    case 0xA1:
+        sim.seg_remap = cmd & 1;
+        break;
+    case 0xA6:
+    case 0xA7:
+        sim.inverted = cmd & 1;
+        break;
+    case 0xAE:
+    case 0xAF:
+        sim.display_on = cmd & 1;
+        break;
+    case 0xC0:
+    case 0xC8:
+        sim.com_remap = (cmd == 0xC8);
+        break;
+    default:
+        // Lệnh chỉ dùng trong Page Addressing Mode
+        if (cmd >= 0xB0 && cmd <= 0xB7)
+            sim.page = cmd & 0x07;
+        else if (cmd <= 0x0F)
+            sim.col = (sim.col & 0xF0) | cmd;
+        else if (cmd >= 0x10 && cmd <= 0x1F)
+            sim.col = ((cmd & 0x07) << 4) | (sim.col & 0x0F);
+        break;
+    }
+}
+
+static void sim_command_byte(uint8_t b)
+{
+    sim.counters.command_bytes++;
+    if (sim.param_needed)
+    {
+        sim.params[sim.param_count++] = b;
+        if (sim.param_count == sim.param_needed)
+        {
+            sim.param_needed = 0;
+            sim_execute(sim.cmd, sim.params);
+        }
+        return;
+    }
+    sim.cmd = b;
+    sim.param_count = 0;
+    sim.param_needed = sim_param_count(b);
+    if (!sim.param_needed)
+        sim_execute(b, sim.params);
+}
+
+// Ghi một byte vào GDDRAM rồi tăng con trỏ địa chỉ theo chế độ hiện tại
+static void sim_data_byte(uint8_t b)
+{
+    sim.counters.data_bytes++;
+    sim.gddram[sim.page & 0x07][sim.col & 0x7F] = b;
+
+    switch (sim.mode)
+    {
+    case SIM_ADDR_HORIZONTAL:
+        if (sim.col >= sim.col_end)
+        {
+            sim.col = sim.col_start;
+            sim.page = (sim.page >= sim.page_end) ? sim.page_start : sim.page + 1;
+        }
+        else
+        {
+            sim.col++;
+        }
+        break;
+    case SIM_ADDR_VERTICAL:
+        if (sim.page >= sim.page_end)
+        {
+            sim.page = sim.page_start;
+            sim.col = (sim.col >= sim.col_end) ? sim.col_start : sim.col + 1;
+        }
+        else
+        {
+            sim.page++;
+        }
+        break;
+    default: // Page Addressing Mode: chỉ tăng cột, quay vòng trong trang
+        sim.col = (sim.col + 1) & 0x7F;
+        break;
+    }
+}
+
+void ssd1306_sim_reset(void)
+{
+    memset(&sim, 0, sizeof(sim));
+    sim.mode = SIM_ADDR_PAGE; // Mặc định sau reset theo datasheet
+    sim.col_end = SIM_WIDTH - 1;
+    sim.page_end = SIM_PAGES - 1;
+}
+
+esp_err_t ssd1306_sim_write(const uint8_t *data, size_t len)
+{
+    if (data == NULL || len == 0)
+        return ESP_ERR_INVALID_ARG;
+
+    sim.counters.transactions++;
+    sim.counters.bytes += len;
+
+    size_t i = 0;
+    while (i < len)
+    {
+        uint8_t control = data[i++];
+        bool is_data = control & 0x40;
+        bool continuation = control & 0x80; // Co = 1: chỉ một byte rồi đến control byte mới
+
+        if (continuation)
+        {
+            if (i < len)
+                is_data ? sim_data_byte(data[i++]) : sim_command_byte(data[i++]);
+            continue;
+        }
+        for (; i < len; i++)
+            is_data ? sim_data_byte(data[i]) : sim_command_byte(data[i]);
+    }
+    return ESP_OK;
+}
+
+void ssd1306_sim_get_counters(ssd1306_sim_counters_t *out)
+{
+    *out = sim.counters;
+}
+
+void ssd1306_sim_reset_counters(void)
+{
+    memset(&sim.counters, 0, sizeof(sim.counters));
+}
+
+bool ssd1306_sim_get_pixel(uint8_t x, uint8_t y)
+{
+    if (x >= SIM_WIDTH || y >= SIM_HEIGHT || !sim.display_on)
+        return false;
+    // A1 + C8 là hướng hiển thị bình thường của module
+    uint8_t col = sim.seg_remap ? x : SIM_WIDTH - 1 - x;
+    uint8_t row = sim.com_remap ? y : SIM_HEIGHT - 1 - y;
+    bool on = (sim.gddram[row / 8][col] >> (row % 8)) & 1;
+    return on != sim.inverted;
+}
+
+esp_err_t ssd1306_sim_write_pbm(const char *path)
+{
+    FILE *f = fopen(path, "wb");
+    if (f == NULL)
+        return ESP_FAIL;
+
+    // PBM nhị phân: 1 = điểm sáng (đen trong ảnh), mỗi hàng 16 byte
+    fprintf(f, "P4\n%d %d\n", SIM_WIDTH, SIM_HEIGHT);
+    for (uint8_t y = 0; y < SIM_HEIGHT; y++)
+    {
+        uint8_t row[SIM_WIDTH / 8] = {0};
+        for (uint8_t x = 0; x < SIM_WIDTH; x++)
+            if (ssd1306_sim_get_pixel(x, y))
+                row[x / 8] |= 0x80 >> (x % 8);
+        fwrite(row, 1, sizeof(row), f);
+    }
+    return fclose(f) == 0 ? ESP_OK : ESP_FAIL;
+}
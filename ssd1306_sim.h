@@ -0,0 +1,72 @@
+#ifndef SSD1306_SIM_H
+#define SSD1306_SIM_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+    /**
+     * @brief Bộ đếm lưu lượng I2C mà bộ giả lập đã nhận.
+     */
+    typedef struct
+    {
+        uint32_t transactions;  // Số giao dịch I2C (mỗi lần start/stop)
+        uint32_t bytes;         // Tổng số byte, kể cả control byte
+        uint32_t command_bytes; // Số byte lệnh (kể cả tham số)
+        uint32_t data_bytes;    // Số byte ghi vào GDDRAM
+    } ssd1306_sim_counters_t;
+
+    /**
+     * @brief Đưa bộ giả lập về trạng thái sau khi bật nguồn (GDDRAM = 0, địa chỉ về gốc).
+     */
+    void ssd1306_sim_reset(void);
+
+    /**
+     * @brief Nhận một giao dịch I2C gửi tới SSD1306 và giải mã lệnh/dữ liệu trong đó.
+     *
+     * Hỗ trợ control byte 0x00/0x40/0x80/0xC0, các chế độ địa chỉ page,
+     * horizontal, vertical và lệnh đặt cửa sổ 0x21/0x22.
+     *
+     * @param data Dữ liệu giao dịch (byte đầu là control byte).
+     * @param len Độ dài dữ liệu.
+     * @return ESP_OK, hoặc ESP_ERR_INVALID_ARG nếu giao dịch rỗng.
+     */
+    esp_err_t ssd1306_sim_write(const uint8_t *data, size_t len);
+
+    /**
+     * @brief Lấy bộ đếm lưu lượng kể từ lần reset bộ đếm gần nhất.
+     */
+    void ssd1306_sim_get_counters(ssd1306_sim_counters_t *out);
+
+    /**
+     * @brief Xóa bộ đếm lưu lượng (không ảnh hưởng GDDRAM).
+     */
+    void ssd1306_sim_reset_counters(void);
+
+    /**
+     * @brief Đọc điểm ảnh (x, y) như người dùng nhìn thấy trên màn hình.
+     *
+     * Đã áp dụng segment remap (0xA0/0xA1), COM scan (0xC0/0xC8), đảo màu
+     * (0xA6/0xA7) và bật/tắt màn hình (0xAE/0xAF).
+     */
+    bool ssd1306_sim_get_pixel(uint8_t x, uint8_t y);
+
+    /**
+     * @brief Ghi ảnh 128x64 đang hiển thị ra file PBM (P4) để so sánh ảnh mẫu.
+     *
+     * @param path Đường dẫn file.
+     * @return ESP_OK hoặc ESP_FAIL nếu không ghi được file.
+     */
+    esp_err_t ssd1306_sim_write_pbm(const char *path);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // SSD1306_SIM_H
@@ -0,0 +1,227 @@
+#include "sysmon.h"
+#include <stdio.h>
+#include <string.h>
+#include <esp_log.h>
+#include "hal.h"
+
+static const char *TAG = "sysmon";
+
+// Các task đã đăng ký; chỉ sửa trong sysmon_lock
+static struct
+{
+    TaskHandle_t task;
+    uint32_t stack_bytes;
+} tasks[SYSMON_MAX_TASKS];
+static portMUX_TYPE sysmon_lock = portMUX_INITIALIZER_UNLOCKED;
+
+static TaskHandle_t sysmon_task_handle = NULL;
+static uint32_t last_free_heap = 0;
+
+// Bảng task có thể được lấy từ sysmon task và từ UDP task (gói truy vấn)
+SYSMON_MUTEX_STORAGE(sysmon_format);
+static SemaphoreHandle_t format_lock = NULL;
+
+#define SYSMON_RUNTIME_STATS (configUSE_TRACE_FACILITY && configGENERATE_RUN_TIME_STATS)
+
+#if SYSMON_RUNTIME_STATS
+#define SYSMON_STATUS_MAX 32 // Đủ cho task của ESP-IDF (Wi-Fi, lwIP, idle, timer...) và của xe
+
+static TaskStatus_t status[SYSMON_STATUS_MAX];
+// Bộ đếm thời gian chạy ở lần lấy trước, để tính % CPU trong khoảng giữa hai lần
+static struct
+{
+    UBaseType_t number;
+    uint32_t runtime;
+} prev_runtime[SYSMON_STATUS_MAX];
+static uint32_t prev_total = 0;
+
+#if configTASKLIST_INCLUDE_COREID
+#define SYSMON_CORE(s) ((s)->xCoreID == tskNO_AFFINITY ? -1 : (int)(s)->xCoreID)
+#else
+#define SYSMON_CORE(s) (-1)
+#endif
+#endif
+
+TaskHandle_t sysmon_task_created(TaskHandle_t task, uint32_t stack_bytes)
+{
+    if (task == NULL)
+        return NULL;
+
+    bool added = false;
+    portENTER_CRITICAL(&sysmon_lock);
+    for (int i = 0; i < SYSMON_MAX_TASKS && !added; i++)
+    {
+        if (tasks[i].task == NULL)
+        {
+            tasks[i].task = task;
+            tasks[i].stack_bytes = stack_bytes;
+            added = true;
+        }
+    }
+    portEXIT_CRITICAL(&sysmon_lock);
+    if (!added)
+        ESP_LOGW(TAG, "Hết chỗ đăng ký task (SYSMON_MAX_TASKS = %d)", SYSMON_MAX_TASKS);
+    return task;
+}
+
+void sysmon_task_deleted(TaskHandle_t task)
+{
+    if (task == NULL)
+        task = xTaskGetCurrentTaskHandle();
+
+    portENTER_CRITICAL(&sysmon_lock);
+    for (int i = 0; i < SYSMON_MAX_TASKS; i++)
+    {
+        if (tasks[i].task == task)
+            tasks[i].task = NULL;
+    }
+    portEXIT_CRITICAL(&sysmon_lock);
+}
+
+// Kích thước stack đã cấp của task đã đăng ký; 0 nếu không rõ (task của ESP-IDF)
+static uint32_t sysmon_stack_size(TaskHandle_t task)
+{
+    uint32_t stack_bytes = 0;
+    portENTER_CRITICAL(&sysmon_lock);
+    for (int i = 0; i < SYSMON_MAX_TASKS; i++)
+    {
+        if (tasks[i].task == task)
+            stack_bytes = tasks[i].stack_bytes;
+    }
+    portEXIT_CRITICAL(&sysmon_lock);
+    return stack_bytes;
+}
+
+#if SYSMON_RUNTIME_STATS
+// % thời gian một core dành cho task kể từ lần gọi trước, cập nhật bộ đếm đã lưu
+static uint32_t sysmon_cpu_percent(const TaskStatus_t *s, uint32_t total_delta)
+{
+    uint32_t runtime = (uint32_t)s->ulRunTimeCounter;
+    uint32_t last = 0;
+    int slot = -1;
+    for (int i = 0; i < SYSMON_STATUS_MAX; i++)
+    {
+        if (prev_runtime[i].number == s->xTaskNumber)
+        {
+            last = prev_runtime[i].runtime;
+            slot = i;
+            break;
+        }
+        if (slot < 0 && prev_runtime[i].number == 0)
+            slot = i;
+    }
+    if (slot >= 0)
+    {
+        prev_runtime[slot].number = s->xTaskNumber;
+        prev_runtime[slot].runtime = runtime;
+    }
+    return total_delta ? (uint32_t)((uint64_t)(runtime - last) * 100 / total_delta) : 0;
+}
+
+// Giải phóng slot của task không còn trong snapshot (task đã bị xóa). xTaskNumber không
+// được dùng lại, nên không dọn thì mỗi task tạo lại chiếm thêm một slot tới khi hết chỗ.
+static void sysmon_prune_runtime(UBaseType_t count)
+{
+    for (int i = 0; i < SYSMON_STATUS_MAX; i++)
+    {
+        if (prev_runtime[i].number == 0)
+            continue;
+        bool alive = false;
+        for (UBaseType_t j = 0; j < count && !alive; j++)
+            alive = status[j].xTaskNumber == prev_runtime[i].number;
+        if (!alive)
+            prev_runtime[i].number = 0;
+    }
+}
+#endif
+
+size_t sysmon_format_tasks(char *buf, size_t len)
+{
+    size_t n = 0;
+    if (format_lock != NULL)
+        xSemaphoreTake(format_lock, portMAX_DELAY);
+
+#if SYSMON_RUNTIME_STATS
+    configRUN_TIME_COUNTER_TYPE total = 0;
+    UBaseType_t count = uxTaskGetSystemState(status, SYSMON_STATUS_MAX, &total);
+    uint32_t total_delta = (uint32_t)total - prev_total;
+    prev_total = (uint32_t)total;
+    if (count == 0)
+        n = (size_t)snprintf(buf, len, "hơn %d task, tăng SYSMON_STATUS_MAX\n", SYSMON_STATUS_MAX);
+    else
+        sysmon_prune_runtime(count); // Trước khi tính: đủ slot cho mọi task trong snapshot
+    for (UBaseType_t i = 0; i < count && n < len; i++)
+    {
+        const TaskStatus_t *s = &status[i];
+        n += (size_t)snprintf(buf + n, len - n, "%-12s core %2d prio %2u cpu %3u%% stack free %5u/%5u B\n",
+                              s->pcTaskName, SYSMON_CORE(s), (unsigned)s->uxCurrentPriority,
+                              (unsigned)sysmon_cpu_percent(s, total_delta),
+                              (unsigned)s->usStackHighWaterMark, (unsigned)sysmon_stack_size(s->xHandle));
+    }
+#else
+    // Không có run-time stats: chỉ báo stack của các task đã đăng ký.
+    // Đọc tên và high-water mark trong khóa để task không bị xóa giữa chừng.
+    for (int i = 0; i < SYSMON_MAX_TASKS && n < len; i++)
+    {
+        char name[configMAX_TASK_NAME_LEN] = "";
+        uint32_t stack_bytes = 0, unused = 0;
+        portENTER_CRITICAL(&sysmon_lock);
+        if (tasks[i].task != NULL)
+        {
+            strncpy(name, pcTaskGetName(tasks[i].task), sizeof(name) - 1);
+            stack_bytes = tasks[i].stack_bytes;
+            unused = uxTaskGetStackHighWaterMark(tasks[i].task);
+        }
+        portEXIT_CRITICAL(&sysmon_lock);
+        if (name[0] != '\0')
+            n += (size_t)snprintf(buf + n, len - n, "%-12s stack free %5u/%5u B\n",
+                                  name, (unsigned)unused, (unsigned)stack_bytes);
+    }
+#endif
+
+    if (format_lock != NULL)
+        xSemaphoreGive(format_lock);
+    return n < len ? n : (len ? len - 1 : 0);
+}
+
+void sysmon_report(void)
+{
+    uint32_t free_heap = hal_free_heap();
+    int32_t delta = last_free_heap ? (int32_t)(free_heap - last_free_heap) : 0;
+    last_free_heap = free_heap;
+    ESP_LOGI(TAG, "heap free=%u min=%u delta=%d | %s",
+             (unsigned)free_heap, (unsigned)hal_min_free_heap(), (int)delta,
+             SYSMON_STATIC_ALLOC ? "static alloc" : "dynamic alloc");
+
+    static char report[SYSMON_REPORT_LEN];
+    sysmon_format_tasks(report, sizeof(report));
+    char *save = NULL;
+    for (char *line = strtok_r(report, "\n", &save); line != NULL; line = strtok_r(NULL, "\n", &save))
+        ESP_LOGI(TAG, "  %s", line);
+}
+
+/*------------------------------------------------------------
+ * Sysmon task: báo cáo bộ nhớ định kỳ. Trong lúc lái xe heap
+ * delta phải bằng 0; khác 0 nghĩa là có cấp phát trên đường nóng.
+ *------------------------------------------------------------*/
+static void sysmon_task(void *pvParameters)
+{
+    TickType_t last_wake = xTaskGetTickCount();
+    while (1)
+    {
+        vTaskDelayUntil(&last_wake, pdMS_TO_TICKS(SYSMON_PERIOD_MS));
+        sysmon_report();
+    }
+}
+
+SYSMON_TASK_STORAGE(sysmon, TASK_SYSMON_STACK);
+
+void start_sysmon_task(void)
+{
+    if (sysmon_task_handle == NULL)
+    {
+        format_lock = SYSMON_MUTEX_CREATE(sysmon_format);
+        SYSMON_TASK_CREATE(sysmon, sysmon_task, "sysmon", NULL, TASK_SYSMON_PRIO, TASK_SYSMON_CORE, &sysmon_task_handle);
+        ESP_LOGI(TAG, "Sysmon task started (%d ms)", SYSMON_PERIOD_MS);
+    }
+}
@@ -0,0 +1,118 @@
+#ifndef SYSMON_H
+#define SYSMON_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <freertos/queue.h>
+#include <freertos/semphr.h>
+#include <freertos/event_groups.h>
+#include "task_config.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+// 1: mọi task, hàng đợi, mutex, event group của ứng dụng dùng bộ nhớ tĩnh
+// (xTaskCreateStatic...), không cấp phát heap sau khi khởi động
+#ifndef SYSMON_STATIC_ALLOC
+#define SYSMON_STATIC_ALLOC 0
+#endif
+
+#define SYSMON_PERIOD_MS 10000 // Chu kỳ báo cáo bộ nhớ
+#define SYSMON_MAX_TASKS 12
+#define SYSMON_REPORT_LEN 1400 // Vừa một gói UDP
+
+/*
+ * Khai báo bộ nhớ (đặt ở phạm vi file) và tạo đối tượng RTOS theo SYSMON_STATIC_ALLOC.
+ * Kích thước stack tính theo byte như xTaskCreate của ESP-IDF; stack, ưu tiên và
+ * core của từng task lấy từ task_config.h. Task được tạo qua SYSMON_TASK_CREATE
+ * tự đăng ký để báo cáo stack high-water mark.
+ *
+ *   SYSMON_TASK_STORAGE(udp, TASK_UDP_STACK);
+ *   SYSMON_TASK_CREATE(udp, udp_listener_task, "udp_listener", NULL,
+ *                      TASK_UDP_PRIO, TASK_UDP_CORE, &udp_task_handle);
+ */
+#if SYSMON_STATIC_ALLOC
+#define SYSMON_TASK_STORAGE(id, stack_bytes) \
+    static StackType_t id##_stack_buf[stack_bytes]; \
+    static StaticTask_t id##_tcb_buf
+#define SYSMON_TASK_CREATE(id, fn, name, arg, prio, core, handle)                           \
+    (*(handle) = sysmon_task_created(                                                       \
+         xTaskCreateStaticPinnedToCore(fn, name, sizeof(id##_stack_buf) / sizeof(StackType_t), \
+                                       arg, prio, id##_stack_buf, &id##_tcb_buf, core),     \
+         sizeof(id##_stack_buf)))
+
+#define SYSMON_QUEUE_STORAGE(id, length, item_size) \
+    static uint8_t id##_queue_storage_buf[(length) * (item_size)]; \
+    static StaticQueue_t id##_queue_buf
+#define SYSMON_QUEUE_CREATE(id, length, item_size) \
+    xQueueCreateStatic(length, item_size, id##_queue_storage_buf, &id##_queue_buf)
+
+#define SYSMON_MUTEX_STORAGE(id) static StaticSemaphore_t id##_mutex_buf
+#define SYSMON_MUTEX_CREATE(id) xSemaphoreCreateMutexStatic(&id##_mutex_buf)
+
+#define SYSMON_EVENT_GROUP_STORAGE(id) static StaticEventGroup_t id##_events_buf
+#define SYSMON_EVENT_GROUP_CREATE(id) xEventGroupCreateStatic(&id##_events_buf)
+#else
+#define SYSMON_TASK_STORAGE(id, stack_bytes) enum { id##_stack_bytes = (stack_bytes) }
+#define SYSMON_TASK_CREATE(id, fn, name, arg, prio, core, handle)                         \
+    (xTaskCreatePinnedToCore(fn, name, id##_stack_bytes, arg, prio, handle, core) == pdPASS \
+         ? sysmon_task_created(*(handle), id##_stack_bytes)                               \
+         : (*(handle) = NULL))
+
+#define SYSMON_QUEUE_STORAGE(id, length, item_size) enum { id##_queue_unused }
+#define SYSMON_QUEUE_CREATE(id, length, item_size) xQueueCreate(length, item_size)
+
+#define SYSMON_MUTEX_STORAGE(id) enum { id##_mutex_unused }
+#define SYSMON_MUTEX_CREATE(id) xSemaphoreCreateMutex()
+
+#define SYSMON_EVENT_GROUP_STORAGE(id) enum { id##_events_unused }
+#define SYSMON_EVENT_GROUP_CREATE(id) xEventGroupCreate()
+#endif
+
+    /**
+     * @brief Đăng ký task để báo cáo stack; dùng qua SYSMON_TASK_CREATE.
+     *
+     * @param task Handle của task vừa tạo (NULL thì bỏ qua).
+     * @param stack_bytes Kích thước stack đã cấp.
+     * @return chính task.
+     */
+    TaskHandle_t sysmon_task_created(TaskHandle_t task, uint32_t stack_bytes);
+
+    /**
+     * @brief Bỏ đăng ký task trước khi xóa nó.
+     *
+     * @param task Task sắp bị xóa; NULL là task đang gọi.
+     */
+    void sysmon_task_deleted(TaskHandle_t task);
+
+    /**
+     * @brief Ghi bảng task vào buf, mỗi task một dòng.
+     *
+     * Khi có CONFIG_FREERTOS_USE_TRACE_FACILITY và CONFIG_FREERTOS_GENERATE_RUN_TIME_STATS:
+     * mọi task (kể cả Wi-Fi/lwIP) với core, ưu tiên, % CPU của một core kể từ lần gọi
+     * trước và stack chưa dùng tới. Nếu không, chỉ stack của các task đã đăng ký.
+     *
+     * @return Số byte đã ghi (không tính '\0').
+     */
+    size_t sysmon_format_tasks(char *buf, size_t len);
+
+    /**
+     * @brief Ghi log stack high-water mark của các task đã đăng ký, heap trống
+     * hiện tại, heap trống thấp nhất từ lúc khởi động và thay đổi so với lần trước.
+     */
+    void sysmon_report(void);
+
+    /**
+     * @brief Tạo task gọi sysmon_report() mỗi SYSMON_PERIOD_MS (chỉ tạo một lần).
+     */
+    void start_sysmon_task(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // SYSMON_H
@@ -0,0 +1,74 @@
+#ifndef TASK_CONFIG_H
+#define TASK_CONFIG_H
+
+#include <freertos/FreeRTOS.h>
+#include "sdkconfig.h"
+
+/*
+ * Kế hoạch lập lịch cho các task của firmware.
+ *
+ *   Core giao thức (PRO_CPU, core 0): Wi-Fi (ưu tiên 23) và lwIP tcpip (18) của
+ *     ESP-IDF, cùng các task hiển thị/báo cáo ưu tiên thấp của xe.
+ *   Core ứng dụng (APP_CPU, core 1): chỉ đường điều khiển. Ưu tiên cao hơn mọi
+ *     task khác trên core này nên gói đến là được xử lý ngay, không chờ OLED.
+ *
+ *   Task          Core  Ưu tiên  Ghi chú
+ *   motor_ramp    APP   12       Đảo chiều sau khi fade về 0 (do ISR LEDC đánh thức)
+ *   failsafe      APP   11       Chu kỳ FAILSAFE_TICK_MS, phải chen được UDP task
+ *   udp_listener  APP   10       recvfrom -> servo/motor
+ *   display       PRO   3
+ *   oled_io       PRO   2        Chặn trên I2C, không được chiếm core điều khiển
+ *   telemetry     PRO   2
+ *   sysmon        PRO   1
+ *
+ * sdkconfig cần giữ Wi-Fi và lwIP trên core 0 (mặc định của ESP-IDF):
+ *   CONFIG_ESP_WIFI_TASK_PINNED_TO_CORE_0=y
+ *   CONFIG_LWIP_TCPIP_TASK_AFFINITY_CPU0=y
+ * Thống kê CPU theo task (sysmon) cần thêm:
+ *   CONFIG_FREERTOS_USE_TRACE_FACILITY=y
+ *   CONFIG_FREERTOS_GENERATE_RUN_TIME_STATS=y
+ */
+
+#if CONFIG_FREERTOS_UNICORE || CONFIG_IDF_TARGET_LINUX
+#define TASK_CORE_PRO tskNO_AFFINITY
+#define TASK_CORE_APP tskNO_AFFINITY
+#else
+#define TASK_CORE_PRO 0
+#define TASK_CORE_APP 1
+#endif
+
+#if CONFIG_ESP_WIFI_TASK_PINNED_TO_CORE_1 || CONFIG_LWIP_TCPIP_TASK_AFFINITY_CPU1
+#warning "Wi-Fi/lwIP đang chạy trên core ứng dụng, trùng với task điều khiển (xem task_config.h)"
+#endif
+
+// Đường điều khiển
+#define TASK_MOTOR_RAMP_PRIO 12
+#define TASK_MOTOR_RAMP_CORE TASK_CORE_APP
+#define TASK_MOTOR_RAMP_STACK 2048
+
+#define TASK_FAILSAFE_PRIO 11
+#define TASK_FAILSAFE_CORE TASK_CORE_APP
+#define TASK_FAILSAFE_STACK 2048
+
+#define TASK_UDP_PRIO 10
+#define TASK_UDP_CORE TASK_CORE_APP
+#define TASK_UDP_STACK 4096
+
+// Hiển thị và báo cáo
+#define TASK_DISPLAY_PRIO 3
+#define TASK_DISPLAY_CORE TASK_CORE_PRO
+#define TASK_DISPLAY_STACK 3072
+
+#define TASK_OLED_IO_PRIO 2
+#define TASK_OLED_IO_CORE TASK_CORE_PRO
+#define TASK_OLED_IO_STACK 3072
+
+#define TASK_TELEMETRY_PRIO 2
+#define TASK_TELEMETRY_CORE TASK_CORE_PRO
+#define TASK_TELEMETRY_STACK 3072
+
+#define TASK_SYSMON_PRIO 1
+#define TASK_SYSMON_CORE TASK_CORE_PRO
+#define TASK_SYSMON_STACK 3072
+
+#endif // TASK_CONFIG_H
@@ -0,0 +1,133 @@
+#include "telemetry.h"
+#include <string.h>
+#include <errno.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <esp_log.h>
+#include "sdkconfig.h"
+#if CONFIG_IDF_TARGET_LINUX
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <unistd.h>
+#else
+#include <lwip/sockets.h>
+#endif
+#include "hal.h"
+#include "motor.h"
+#include "sysmon.h"
+#include "control.h"
+
+static const char *TAG = "telemetry";
+
+#define TELEMETRY_IDLE_MS 500 // Chu kỳ kiểm tra lại khi telemetry bị tắt
+
+// Bộ giải mã Dart đọc theo offset cố định
+_Static_assert(sizeof(telemetry_packet_t) == TELEMETRY_PACKET_LEN, "telemetry_packet_t size");
+
+static TaskHandle_t telemetry_task_handle = NULL;
+static volatile uint32_t telemetry_rate_hz = TELEMETRY_RATE_HZ;
+
+// Dựng gói trạng thái từ thống kê của control.c và trạng thái PWM hiện tại
+static void telemetry_build(telemetry_packet_t *pkt, uint32_t seq, uint16_t packet_rate)
+{
+    control_stats_t stats;
+    control_get_stats(&stats);
+
+    memset(pkt, 0, sizeof(*pkt));
+    pkt->magic = TELEMETRY_MAGIC;
+    pkt->version = TELEMETRY_VERSION;
+    pkt->motor_direction = (int8_t)motor_get_direction();
+    pkt->seq = seq;
+    pkt->uptime_ms = (uint32_t)(hal_time_us() / 1000);
+    pkt->motor_duty = (uint16_t)hal_pwm_get_duty(HAL_PWM_MOTOR);
+    pkt->servo_duty = (uint16_t)hal_pwm_get_duty(HAL_PWM_SERVO);
+    pkt->control_seq = stats.last_seq;
+    pkt->packet_rate = packet_rate;
+    pkt->packets = stats.packets;
+    pkt->stale_dropped = stats.stale_dropped;
+    pkt->dropped = stats.duplicates + stats.reordered;
+    pkt->invalid = stats.invalid;
+    pkt->loop_us = (uint32_t)stats.last_latency_us;
+    pkt->loop_max_us = (uint32_t)stats.max_latency_us;
+    pkt->jitter_us = stats.jitter_us;
+    pkt->free_heap = hal_free_heap();
+    pkt->lease_rejected = stats.lease_rejected;
+    pkt->lease_changes = stats.lease_changes;
+}
+
+/*---------------------------------------------------------------
+ * Telemetry task:
+ * Mỗi chu kỳ 1/telemetry_rate_hz gửi một telemetry_packet_t tới người
+ * điều khiển gần nhất. Dùng socket riêng để không chia sẻ socket với
+ * UDP listener; điện thoại nhận trên chính cổng nó dùng để gửi lệnh.
+ *--------------------------------------------------------------*/
+static void telemetry_task(void *pvParameters)
+{
+    // Stack/TCB tĩnh: không tự xóa task khi lỗi (start lại sẽ tạo đè lên TCB idle task
+    // chưa dọn), chỉ thử tạo socket lại sau mỗi giây
+    int sock;
+    while ((sock = socket(AF_INET, SOCK_DGRAM, IPPROTO_IP)) < 0)
+    {
+        ESP_LOGE(TAG, "Không thể tạo socket");
+        vTaskDelay(pdMS_TO_TICKS(1000));
+    }
+
+    uint32_t seq = 0;
+    uint32_t last_packets = 0;
+    int64_t last_time_us = hal_time_us();
+    TickType_t wake = xTaskGetTickCount();
+
+    while (1)
+    {
+        uint32_t rate = telemetry_rate_hz;
+        if (rate == 0)
+        {
+            vTaskDelay(pdMS_TO_TICKS(TELEMETRY_IDLE_MS));
+            wake = xTaskGetTickCount();
+            continue;
+        }
+        TickType_t period = pdMS_TO_TICKS(1000 / rate);
+        vTaskDelayUntil(&wake, period > 0 ? period : 1);
+
+        uint32_t addr;
+        uint16_t port;
+        if (!control_get_peer(&addr, &port))
+            continue;
+
+        // Tốc độ gói điều khiển tính trên khoảng thời gian thực giữa hai lần gửi
+        control_stats_t stats;
+        control_get_stats(&stats);
+        int64_t now_us = hal_time_us();
+        int64_t elapsed_us = now_us - last_time_us;
+        uint32_t rate_pps = elapsed_us > 0 ? (uint32_t)((int64_t)(stats.packets - last_packets) * 1000000 / elapsed_us) : 0;
+        last_packets = stats.packets;
+        last_time_us = now_us;
+
+        telemetry_packet_t pkt;
+        telemetry_build(&pkt, seq++, rate_pps > UINT16_MAX ? UINT16_MAX : (uint16_t)rate_pps);
+
+        struct sockaddr_in dest = {
+            .sin_family = AF_INET,
+            .sin_port = port,
+            .sin_addr.s_addr = addr,
+        };
+        if (sendto(sock, &pkt, sizeof(pkt), 0, (struct sockaddr *)&dest, sizeof(dest)) < 0)
+            ESP_LOGD(TAG, "Gửi telemetry lỗi: %d", errno);
+    }
+}
+
+SYSMON_TASK_STORAGE(telemetry, TASK_TELEMETRY_STACK);
+
+void start_telemetry_task(void)
+{
+    if (telemetry_task_handle == NULL)
+    {
+        SYSMON_TASK_CREATE(telemetry, telemetry_task, "telemetry", NULL, TASK_TELEMETRY_PRIO, TASK_TELEMETRY_CORE, &telemetry_task_handle);
+        ESP_LOGI(TAG, "Telemetry task started (%u Hz)", (unsigned)telemetry_rate_hz);
+    }
+}
+
+void telemetry_set_rate(uint32_t rate_hz)
+{
+    telemetry_rate_hz = rate_hz > TELEMETRY_RATE_MAX_HZ ? TELEMETRY_RATE_MAX_HZ : rate_hz;
+}
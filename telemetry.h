@@ -0,0 +1,65 @@
+#ifndef TELEMETRY_H
+#define TELEMETRY_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#define TELEMETRY_RATE_HZ 5     // Tần số gửi mặc định
+#define TELEMETRY_RATE_MAX_HZ 50
+#define TELEMETRY_MAGIC 0x5452  // 'R', 'T'
+#define TELEMETRY_VERSION 2
+#define TELEMETRY_PACKET_LEN 64
+
+    /**
+     * @brief Gói trạng thái gửi từ xe về bộ điều khiển, little endian, kích thước cố định.
+     *
+     * Gửi tới địa chỉ/cổng nguồn của gói điều khiển hợp lệ gần nhất
+     * (control_get_peer()). Bộ giải mã tương ứng: TelemetryPacket trong appAndroiV4.dart.
+     */
+    typedef struct __attribute__((packed))
+    {
+        uint16_t magic;          // TELEMETRY_MAGIC
+        uint8_t version;         // TELEMETRY_VERSION
+        int8_t motor_direction;  // 1 tiến, -1 lùi, 0 dừng
+        uint32_t seq;            // Số thứ tự gói telemetry
+        uint32_t uptime_ms;
+        uint16_t motor_duty;     // Duty PWM motor đang áp dụng
+        uint16_t servo_duty;     // Duty PWM servo đang áp dụng
+        uint32_t control_seq;    // Seq của gói điều khiển v1 được nhận gần nhất
+        uint16_t packet_rate;    // Gói điều khiển được áp dụng mỗi giây
+        uint16_t reserved;
+        uint32_t packets;        // Tổng gói điều khiển đã áp dụng
+        uint32_t stale_dropped;
+        uint32_t dropped;        // Gói trùng + sai thứ tự
+        uint32_t invalid;
+        uint32_t loop_us;        // recvfrom -> actuation của gói gần nhất (us)
+        uint32_t loop_max_us;
+        uint32_t jitter_us;
+        uint32_t free_heap;
+        uint32_t lease_rejected; // Gói điều khiển từ người không giữ quyền bị loại (v2)
+        uint32_t lease_changes;  // Số lần quyền điều khiển đổi chủ (v2)
+    } telemetry_packet_t;
+
+    /**
+     * @brief Tạo task gửi telemetry (chỉ tạo một lần).
+     *
+     * Task chỉ gửi khi đã có người điều khiển; không ảnh hưởng tới UDP listener.
+     */
+    void start_telemetry_task(void);
+
+    /**
+     * @brief Đổi tần số gửi telemetry.
+     *
+     * @param rate_hz Số gói mỗi giây (tối đa TELEMETRY_RATE_MAX_HZ); 0 để tắt.
+     */
+    void telemetry_set_rate(uint32_t rate_hz);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // TELEMETRY_H
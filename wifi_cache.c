@@ -0,0 +1,60 @@
+#include "wifi_cache.h"
+#include <string.h>
+#include <nvs.h>
+#include <esp_log.h>
+
+static const char *TAG = "wifi_cache";
+
+#define WIFI_CACHE_KEY "ap"
+
+esp_err_t wifi_cache_load(wifi_cache_t *cache)
+{
+    nvs_handle_t handle;
+    esp_err_t err = nvs_open(WIFI_CACHE_NAMESPACE, NVS_READONLY, &handle);
+    if (err != ESP_OK)
+        return ESP_ERR_NOT_FOUND;
+
+    size_t len = sizeof(*cache);
+    err = nvs_get_blob(handle, WIFI_CACHE_KEY, cache, &len);
+    nvs_close(handle);
+    if (err != ESP_OK || len != sizeof(*cache) || cache->version != WIFI_CACHE_VERSION)
+        return ESP_ERR_NOT_FOUND;
+    return ESP_OK;
+}
+
+esp_err_t wifi_cache_save(const wifi_cache_t *cache)
+{
+    wifi_cache_t old;
+    if (wifi_cache_load(&old) == ESP_OK && memcmp(&old, cache, sizeof(old)) == 0)
+        return ESP_OK;
+
+    nvs_handle_t handle;
+    esp_err_t err = nvs_open(WIFI_CACHE_NAMESPACE, NVS_READWRITE, &handle);
+    if (err != ESP_OK)
+        return err;
+    err = nvs_set_blob(handle, WIFI_CACHE_KEY, cache, sizeof(*cache));
+    if (err == ESP_OK)
+        err = nvs_commit(handle);
+    nvs_close(handle);
+
+    if (err == ESP_OK)
+        ESP_LOGI(TAG, "Lưu AP %02x:%02x:%02x:%02x:%02x:%02x kênh %u",
+                 cache->bssid[0], cache->bssid[1], cache->bssid[2],
+                 cache->bssid[3], cache->bssid[4], cache->bssid[5], cache->channel);
+    else
+        ESP_LOGW(TAG, "Không lưu được cache: %s", esp_err_to_name(err));
+    return err;
+}
+
+esp_err_t wifi_cache_clear(void)
+{
+    nvs_handle_t handle;
+    esp_err_t err = nvs_open(WIFI_CACHE_NAMESPACE, NVS_READWRITE, &handle);
+    if (err != ESP_OK)
+        return err;
+    err = nvs_erase_key(handle, WIFI_CACHE_KEY);
+    if (err == ESP_OK)
+        err = nvs_commit(handle);
+    nvs_close(handle);
+    return err == ESP_ERR_NVS_NOT_FOUND ? ESP_OK : err;
+}
@@ -0,0 +1,71 @@
+#ifndef WIFI_CACHE_H
+#define WIFI_CACHE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#define WIFI_CACHE_NAMESPACE "wifi_cache"
+#define WIFI_CACHE_VERSION 1
+
+// Số lần kết nối thất bại liên tiếp bằng BSSID/kênh đã lưu trước khi quét lại toàn bộ
+#ifndef WIFI_FAST_RETRY_MAX
+#define WIFI_FAST_RETRY_MAX 3
+#endif
+// Chỉ khi chưa lấy được IP lần nào trong lần boot này, thông tin Wi-Fi mới bị xóa để
+// quay lại provisioning, và chỉ vì một trong hai lý do: lỗi xác thực liên tiếp (sai mật
+// khẩu) hoặc AP không tìm thấy liên tục đủ lâu. Timeout, mất beacon... chỉ thử lại.
+#ifndef WIFI_PROV_AUTH_FAILS
+#define WIFI_PROV_AUTH_FAILS 5
+#endif
+#ifndef WIFI_PROV_AP_MISSING_MS
+#define WIFI_PROV_AP_MISSING_MS (10 * 60 * 1000)
+#endif
+// 1: dùng lại IP/gateway/netmask đã lưu, bỏ qua DHCP. Mặc định tắt vì router có thể
+// đã cấp địa chỉ đó cho thiết bị khác; chỉ bật khi router đặt IP cố định cho xe.
+#ifndef WIFI_FAST_STATIC_IP
+#define WIFI_FAST_STATIC_IP 0
+#endif
+
+    /**
+     * @brief Thông tin của lần kết nối thành công gần nhất, lưu trong NVS.
+     *
+     * Địa chỉ IPv4 theo thứ tự byte mạng như esp_ip4_addr_t.
+     */
+    typedef struct
+    {
+        uint8_t version; // WIFI_CACHE_VERSION
+        uint8_t channel; // Kênh chính của AP
+        uint8_t bssid[6];
+        uint32_t ip;
+        uint32_t gateway;
+        uint32_t netmask;
+    } wifi_cache_t;
+
+    /**
+     * @brief Đọc cache từ NVS.
+     *
+     * @return ESP_OK nếu có cache hợp lệ, ESP_ERR_NOT_FOUND nếu chưa có hoặc sai phiên bản.
+     */
+    esp_err_t wifi_cache_load(wifi_cache_t *cache);
+
+    /**
+     * @brief Ghi cache vào NVS; không ghi nếu nội dung không đổi để tránh mòn flash.
+     */
+    esp_err_t wifi_cache_save(const wifi_cache_t *cache);
+
+    /**
+     * @brief Xóa cache, lần kết nối sau sẽ quét và dùng DHCP như bình thường.
+     */
+    esp_err_t wifi_cache_clear(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // WIFI_CACHE_H